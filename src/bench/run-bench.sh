@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+
+# Runs every program in bench/ and prints the results as one JSON document.
+# Each program times its work with (benchmark name warmups runs expression),
+# which prints one JSON object per benchmark.  Run from the src directory:
+#
+#   bash bench/run-bench.sh [output.json]
+
+binary=./broccoli
+version=`git describe --always --dirty 2>/dev/null || echo unknown`
+results=""
+
+for program in bench/*.brocc
+do
+    lines=`$binary -f2 broccoli.brocc -f2 $program < /dev/null | grep '^{'`
+    results="${results}${results:+,
+}${lines//$'\n'/,
+}"
+done
+
+json="{
+\"version\": \"${version}\",
+\"date\": \"`date -u +%Y-%m-%dT%H:%M:%SZ`\",
+\"benchmarks\": [
+${results}
+]
+}"
+
+if [ -n "$1" ]
+then
+    echo "$json" > "$1"
+fi
+
+echo "$json"
@@ -118,8 +118,8 @@
 
 #define SCALAR_VARIABLE                35
 #define LIST_VARIABLE                  36
-#define UNUSED_2                       37
-#define UNUSED_3                       38
+#define DATA_OBJECT_VALUE              37
+#define DATA_OBJECT_ERROR              38
 #define BITMAPARRAY                    39
 #define DATA_OBJECT_ARRAY              40
 
@@ -143,6 +143,8 @@
 #define FUNCTION_OPTIONAL_ARG          96
 #define FUNCTION_VAR_META              97
 #define FUNCTION_VAR                   98
+#define BINDING_SLOT_META              99
+#define BINDING_SLOT                  100
 
 #define NOT_CONSTRAINT                160
 #define AND_CONSTRAINT                161
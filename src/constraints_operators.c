@@ -997,8 +997,8 @@ static void _union_numbers_with_list(void *env, struct core_expression *addmin,
                 tmpmax->next_arg = nextmax->next_arg;
                 tmpmin->next_arg = nextmin->next_arg;
 
-                core_mem_return_struct(env, core_expression, nextmin);
-                core_mem_return_struct(env, core_expression, nextmax);
+                core_return_expression_node(env, nextmin);
+                core_return_expression_node(env, nextmax);
             }
             else
             {
@@ -0,0 +1,980 @@
+/* Purpose: Compiles procedure bodies into a flat bytecode
+ *   and executes them with a dispatch loop.
+ *
+ *   The compiler lowers an expression tree into a stack
+ *   program. Constants, parameter references and the
+ *   arguments of ordinary function and deffunction calls
+ *   are evaluated by the loop and handed to the callee as
+ *   pre-evaluated DATA_OBJECT_VALUE argument nodes. progn
+ *   and if bodies become jumps. Everything else (special
+ *   forms, local variables, loops) is left to the
+ *   expression walker through BC_OP_EVAL.                   */
+
+#define __CORE_BYTECODE_SOURCE__
+
+#include "setup.h"
+
+#if BYTECODE_FUNCTIONS
+
+#include <stdio.h>
+#define _STDIO_INCLUDED_
+#include <stdlib.h>
+#include <limits.h>
+
+#include "constant.h"
+#include "core_environment.h"
+#include "core_memory.h"
+#include "core_evaluation.h"
+#include "core_functions.h"
+#include "core_functions_util.h"
+#include "funcs_flow_control.h"
+#include "funcs_function.h"
+#include "functions_kernel.h"
+#include "funcs_comparison.h"
+#include "funcs_math_basic.h"
+#include "router.h"
+#include "core_utilities.h"
+#include "type_symbol.h"
+
+#include "core_bytecode.h"
+
+/*==============================================
+ * Threaded dispatch uses the labels-as-values
+ * extension when the compiler supports it.
+ *==============================================*/
+#ifndef BYTECODE_THREADED_DISPATCH
+#if defined(__GNUC__)
+#define BYTECODE_THREADED_DISPATCH 1
+#else
+#define BYTECODE_THREADED_DISPATCH 0
+#endif
+#endif
+
+#define ERROR_TAG_BYTECODE "Bytecode Error "
+#define INITIAL_CODE_SZ    16
+
+struct bytecode_compiler
+{
+    struct core_bytecode_instruction *code;
+    int                               length;
+    int                               capacity;
+    int                               depth;
+    int                               max_depth;
+};
+
+/**************************************
+ * LOCAL FUNCTION PROTOTYPES
+ ***************************************/
+
+static int            _emit(void *, struct bytecode_compiler *, int, int, int, void *, struct core_expression *, int);
+static void           _compile_statement(void *, struct bytecode_compiler *, struct core_expression *, int);
+static void           _compile_progn(void *, struct bytecode_compiler *, struct core_expression *, int);
+static void           _compile_if(void *, struct bytecode_compiler *, struct core_expression *, int);
+static void           _compile_argument(void *, struct bytecode_compiler *, struct core_expression *);
+static void           _compile_call(void *, struct bytecode_compiler *, struct core_expression *, int, int);
+static int            _is_strict_function(struct core_function_definition *);
+static int            _get_call_opcode(struct core_function_definition *, int *);
+static int            _get_integer_opcode(struct core_function_definition *);
+static BOOLEAN        _add_overflows(long long, long long);
+static BOOLEAN        _sub_overflows(long long, long long);
+static BOOLEAN        _mul_overflows(long long, long long);
+
+/*********************************************************
+ * core_bytecode_compile: Lowers a packed procedure body
+ *   into bytecode. Returns NULL if there is no body.
+ **********************************************************/
+struct core_bytecode *core_bytecode_compile(void *env, struct core_expression *actions)
+{
+    struct bytecode_compiler bc;
+    struct core_bytecode *bytecode;
+
+    if( actions == NULL )
+    {
+        return(NULL);
+    }
+
+    bc.capacity = INITIAL_CODE_SZ;
+    bc.code = (struct core_bytecode_instruction *)
+              core_mem_alloc_no_init(env, sizeof(struct core_bytecode_instruction) * bc.capacity);
+    bc.length = 0;
+    bc.depth = 0;
+    bc.max_depth = 0;
+
+    _compile_statement(env, &bc, actions, TRUE);
+    _emit(env, &bc, BC_OP_RETURN, 0, 0, NULL, NULL, 0);
+
+    bytecode = core_mem_get_struct(env, core_bytecode);
+    bytecode->code = (struct core_bytecode_instruction *)
+                     core_mem_realloc(env, bc.code, sizeof(struct core_bytecode_instruction) * bc.capacity,
+                                      sizeof(struct core_bytecode_instruction) * bc.length);
+    bytecode->length = bc.length;
+    bytecode->stack_sz = bc.max_depth;
+    return(bytecode);
+}
+
+/*********************************************************
+ * core_bytecode_release: Returns the memory used by a
+ *   compiled procedure body. The expressions referenced
+ *   by the bytecode are owned by the body itself.
+ **********************************************************/
+void core_bytecode_release(void *env, struct core_bytecode *bytecode)
+{
+    if( bytecode == NULL )
+    {
+        return;
+    }
+
+    core_mem_release(env, (void *)bytecode->code, sizeof(struct core_bytecode_instruction) * bytecode->length);
+    core_mem_return_struct(env, core_bytecode, bytecode);
+}
+
+/*********************************************************
+ * core_bytecode_execute: Runs a compiled procedure body.
+ *   Returns FALSE if no errors occurred during evaluation,
+ *   otherwise TRUE, in the same manner as
+ *   core_eval_expression.
+ **********************************************************/
+int core_bytecode_execute(void *env, struct core_bytecode *bytecode, core_data_object *result)
+{
+    register struct core_bytecode_instruction *ip;
+    register core_data_object *stack;
+    register int sp;
+    struct core_bytecode_instruction *pc;
+    struct core_expression *args, head, *oldArgument, *rest;
+    struct core_function_definition *fptr;
+    core_data_object *src, value;
+    size_t frameSize;
+    int i, base, height;
+    long long x, y;
+
+#if BYTECODE_THREADED_DISPATCH
+    static void *dispatch[] =
+    {
+        &&op_constant, &&op_argument, &&op_eval, &&op_call,
+        &&op_call_void, &&op_call_bool, &&op_call_long_long, &&op_call_double,
+        &&op_call_lexeme, &&op_call_unknown, &&op_add, &&op_sub,
+        &&op_mul, &&op_eq, &&op_lt, &&op_gt,
+        &&op_le, &&op_ge, &&op_tail_call, &&op_progn,
+        &&op_statement, &&op_jump_false, &&op_jump, &&op_return
+    };
+#define VM_CASE(op, label) label:
+#define VM_NEXT()          goto *dispatch[ip->op]
+#else
+#define VM_CASE(op, label) case op:
+#define VM_NEXT()          continue
+#endif
+
+#define VM_CHECK()                                       \
+    if( core_get_evaluation_data(env)->eval_error )      \
+    {                                                    \
+        goto recover;                                    \
+    }                                                    \
+    VM_NEXT()
+
+#define VM_UNLINK(base, top)                             \
+    head.args = ((top) > (base)) ? &args[base] : NULL;   \
+    if((top) > (base))                                   \
+    {                                                    \
+        args[(top) - 1].next_arg = NULL;                 \
+    }
+
+#define VM_INTEGERS()                                    \
+    if((stack[sp - 2].type != INTEGER) ||                \
+       (stack[sp - 1].type != INTEGER))                  \
+    {                                                    \
+        goto do_call;                                    \
+    }                                                    \
+    x = to_long(stack[sp - 2].value);                    \
+    y = to_long(stack[sp - 1].value)
+
+#define VM_COMPARE(test)                                 \
+    VM_INTEGERS();                                       \
+    sp--;                                                \
+    stack[sp - 1].type = ATOM;                           \
+    stack[sp - 1].value = (test) ? get_true(env) : get_false(env); \
+    ip++;                                                \
+    VM_NEXT()
+
+#define VM_RELINK(base, top)                             \
+    if((top) > (base))                                   \
+    {                                                    \
+        args[(top) - 1].type = DATA_OBJECT_VALUE;        \
+        args[(top) - 1].next_arg =                       \
+            ((top) < bytecode->stack_sz) ? &args[top] : NULL; \
+    }
+
+    /*=====================================================
+     * The frame holds the value stack followed by one
+     * argument expression per stack slot. A call passes
+     * the top argc slots to the callee as a linked list
+     * of DATA_OBJECT_VALUE expressions.
+     *=====================================================*/
+    frameSize = (sizeof(core_data_object) + sizeof(struct core_expression)) * bytecode->stack_sz;
+    stack = (core_data_object *)core_mem_alloc_no_init(env, frameSize);
+    args = (struct core_expression *)(stack + bytecode->stack_sz);
+
+    for( i = 0 ; i < bytecode->stack_sz ; i++ )
+    {
+        args[i].type = DATA_OBJECT_VALUE;
+        args[i].value = (void *)&stack[i];
+        args[i].args = NULL;
+        args[i].next_arg = ((i + 1) < bytecode->stack_sz) ? &args[i + 1] : NULL;
+    }
+
+    head.next_arg = NULL;
+    sp = 0;
+    ip = bytecode->code;
+
+#if BYTECODE_THREADED_DISPATCH
+    VM_NEXT();
+#else
+
+    for( ;; )
+    {
+        switch( ip->op )
+        {
+#endif
+
+    VM_CASE(BC_OP_CONSTANT, op_constant)
+    stack[sp].type = ip->type;
+    stack[sp].value = ip->value;
+    sp++;
+    ip++;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_ARGUMENT, op_argument)
+    src = &core_get_function_primitive_data(env)->arguments[ip->operand - 1];
+    stack[sp].type = src->type;
+    stack[sp].value = src->value;
+    stack[sp].begin = src->begin;
+    stack[sp].end = src->end;
+    sp++;
+    ip++;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_EVAL, op_eval)
+    core_eval_expression(env, ip->expression, &stack[sp]);
+    sp++;
+    ip++;
+    VM_CHECK();
+
+    /*=====================================================
+     * Calls that need the full evaluator treatment, such
+     * as deffunctions, profiled functions or functions
+     * with a context, go through core_eval_expression
+     * with the pre-evaluated arguments attached.
+     *=====================================================*/
+    VM_CASE(BC_OP_CALL, op_call)
+do_call:
+    base = sp - ip->operand;
+    head.type = ip->type;
+    head.value = ip->value;
+    VM_UNLINK(base, sp);
+    core_eval_expression(env, &head, &value);
+    VM_RELINK(base, sp);
+    sp = base;
+    stack[sp++] = value;
+    ip++;
+    VM_CHECK();
+
+    VM_CASE(BC_OP_CALL_VOID, op_call_void)
+    VM_CASE(BC_OP_CALL_BOOL, op_call_bool)
+    VM_CASE(BC_OP_CALL_LONG_LONG, op_call_long_long)
+    VM_CASE(BC_OP_CALL_DOUBLE, op_call_double)
+    VM_CASE(BC_OP_CALL_LEXEME, op_call_lexeme)
+    VM_CASE(BC_OP_CALL_UNKNOWN, op_call_unknown)
+    base = sp - ip->operand;
+    fptr = (struct core_function_definition *)ip->value;
+    head.type = FCALL;
+    head.value = ip->value;
+    VM_UNLINK(base, sp);
+
+    oldArgument = core_get_evaluation_data(env)->current_expression;
+    core_get_evaluation_data(env)->current_expression = &head;
+
+    switch( ip->op )
+    {
+    case BC_OP_CALL_VOID:
+        (*(void(*) (void *))fptr->functionPointer)(env);
+        value.type = RVOID;
+        value.value = get_false(env);
+        break;
+
+    case BC_OP_CALL_BOOL:
+        value.type = ATOM;
+        value.value = (*(int(*) (void *))fptr->functionPointer)(env) ? get_true(env) : get_false(env);
+        break;
+
+    case BC_OP_CALL_LONG_LONG:
+        value.type = INTEGER;
+        value.value = (void *)store_long(env, (*(long long(*) (void *))fptr->functionPointer)(env));
+        break;
+
+    case BC_OP_CALL_DOUBLE:
+        value.type = FLOAT;
+        value.value = (void *)store_double(env, (*(double(*) (void *))fptr->functionPointer)(env));
+        break;
+
+    case BC_OP_CALL_LEXEME:
+        value.type = ip->type;
+        value.value = (void *)(*(ATOM_HN * (*)(void *))fptr->functionPointer)(env);
+        break;
+
+    default:
+        (*(void(*) (void *, core_data_object_ptr))fptr->functionPointer)(env, &value);
+        break;
+    }
+
+    core_get_evaluation_data(env)->current_expression = oldArgument;
+    core_pass_return_value(env, &value);
+    VM_RELINK(base, sp);
+    sp = base;
+    stack[sp++] = value;
+    ip++;
+    VM_CHECK();
+
+#if DEFFUNCTION_CONSTRUCT
+
+    /*=====================================================
+     * A deffunction call whose value is the value of the
+     * body. The arguments are handed to function_execute,
+     * which makes the call once this frame is gone, so
+     * that tail recursion does not grow the C stack.
+     *=====================================================*/
+    VM_CASE(BC_OP_TAIL_CALL, op_tail_call)
+
+    if( core_get_evaluation_data(env)->halt ||
+        get_flow_control_data(env)->break_flag || get_flow_control_data(env)->return_flag ||
+        ((src = function_prepare_tail_call(env, ip->value, ip->operand)) == NULL))
+    {
+        goto do_call;
+    }
+
+    for( i = 0 ; i < ip->operand ; i++ )
+    {
+        src[i] = stack[sp - ip->operand + i];
+    }
+
+    result->type = ATOM;
+    result->value = get_false(env);
+    goto finish;
+#endif
+
+    /*=====================================================
+     * Two argument arithmetic and comparisons on integers
+     * are done in place. Floats, other types and results
+     * that would overflow are left to the function itself.
+     *=====================================================*/
+    VM_CASE(BC_OP_ADD, op_add)
+    VM_INTEGERS();
+
+    if( _add_overflows(x, y))
+    {
+        goto do_call;
+    }
+
+    sp--;
+    stack[sp - 1].value = (void *)store_long(env, x + y);
+    ip++;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_SUB, op_sub)
+    VM_INTEGERS();
+
+    if( _sub_overflows(x, y))
+    {
+        goto do_call;
+    }
+
+    sp--;
+    stack[sp - 1].value = (void *)store_long(env, x - y);
+    ip++;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_MUL, op_mul)
+    VM_INTEGERS();
+
+    if( _mul_overflows(x, y))
+    {
+        goto do_call;
+    }
+
+    sp--;
+    stack[sp - 1].value = (void *)store_long(env, x * y);
+    ip++;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_EQ, op_eq)
+    VM_COMPARE(x == y);
+
+    VM_CASE(BC_OP_LT, op_lt)
+    VM_COMPARE(x < y);
+
+    VM_CASE(BC_OP_GT, op_gt)
+    VM_COMPARE(x > y);
+
+    VM_CASE(BC_OP_LE, op_le)
+    VM_COMPARE(x <= y);
+
+    VM_CASE(BC_OP_GE, op_ge)
+    VM_COMPARE(x >= y);
+
+    /*=====================================================
+     * A progn is not entered once evaluation has halted.
+     *=====================================================*/
+    VM_CASE(BC_OP_PROGN, op_progn)
+
+    if( core_get_evaluation_data(env)->halt )
+    {
+        result->type = ATOM;
+        result->value = get_false(env);
+        goto finish;
+    }
+
+    ip++;
+    VM_NEXT();
+
+    /*=====================================================
+     * Checks made by broccoli_progn after each action.
+     * The operand is TRUE if the value is discarded.
+     *=====================================================*/
+    VM_CASE(BC_OP_STATEMENT, op_statement)
+
+    if( core_get_evaluation_data(env)->halt )
+    {
+        result->type = ATOM;
+        result->value = get_false(env);
+        goto finish;
+    }
+
+    if( get_flow_control_data(env)->break_flag || get_flow_control_data(env)->return_flag )
+    {
+        sp--;
+        goto copy_result;
+    }
+
+    sp -= ip->operand;
+    ip++;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_JUMP_FALSE, op_jump_false)
+    sp--;
+
+    if( get_flow_control_data(env)->break_flag || get_flow_control_data(env)->return_flag )
+    {
+        result->type = ATOM;
+        result->value = get_false(env);
+        goto finish;
+    }
+
+    if((stack[sp].type == ATOM) && (stack[sp].value == get_false(env)))
+    {
+        pc = bytecode->code + ip->operand;
+        rest = ip->expression->args->next_arg->next_arg;
+    }
+    else
+    {
+        pc = ip + 1;
+        rest = ip->expression->args->next_arg;
+    }
+
+    /*=====================================================
+     * broccoli_if goes on with a branch even if the
+     * condition failed. The branch is then left to the
+     * walker, so the loop never runs with a pending error.
+     *=====================================================*/
+    if( core_get_evaluation_data(env)->eval_error )
+    {
+        if( rest != NULL )
+        {
+            core_eval_expression(env, rest, &stack[sp]);
+        }
+        else
+        {
+            stack[sp].type = ATOM;
+            stack[sp].value = get_false(env);
+        }
+
+        sp++;
+        ip = bytecode->code + bytecode->code[ip->operand - 1].operand;
+        VM_NEXT();
+    }
+
+    ip = pc;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_JUMP, op_jump)
+    ip = bytecode->code + ip->operand;
+    VM_NEXT();
+
+    VM_CASE(BC_OP_RETURN, op_return)
+    sp--;
+    goto copy_result;
+
+    /*=====================================================
+     * An argument failed. The walker would have handed it
+     * to the innermost pending call as it was evaluated,
+     * leaving the later arguments alone. Find that call:
+     * the first one ahead that consumes slots below sp.
+     *=====================================================*/
+recover:
+    height = sp;
+
+    for( pc = ip ; pc->op <= BC_OP_TAIL_CALL ; pc++ )
+    {
+        if( pc->op < BC_OP_CALL )
+        {
+            height++;
+        }
+        else if((height - pc->operand) < sp )
+        {
+            break;
+        }
+        else
+        {
+            height = height - pc->operand + 1;
+        }
+    }
+
+    if( pc->op > BC_OP_TAIL_CALL )
+    {
+        VM_NEXT();
+    }
+
+    base = height - pc->operand;
+
+    for( rest = pc->expression->args, i = base ; i < sp ; i++ )
+    {
+        rest = rest->next_arg;
+    }
+
+#if DEFFUNCTION_CONSTRUCT
+
+    if(((pc->op == BC_OP_CALL) || (pc->op == BC_OP_TAIL_CALL)) && (pc->type == PCALL))
+    {
+        error_print_id(env, "FLOW", 6, FALSE);
+        print_router(env, WERROR, "This error occurred while evaluating arguments for the ");
+        print_router(env, WERROR, FUNC_NAME_CREATE_FUNC);
+        print_router(env, WERROR, " ");
+        print_router(env, WERROR, get_function_name(env, pc->value));
+        print_router(env, WERROR, ".\n");
+        value.type = ATOM;
+        value.value = get_false(env);
+    }
+    else
+#endif
+    {
+        /*==================================================
+         * The failed argument raises the error again when
+         * the callee evaluates it, and the arguments after
+         * it are passed unevaluated.
+         *==================================================*/
+        head.type = FCALL;
+        head.value = pc->value;
+        VM_UNLINK(base, sp);
+        args[sp - 1].type = DATA_OBJECT_ERROR;
+        args[sp - 1].next_arg = rest;
+        core_get_evaluation_data(env)->eval_error = FALSE;
+        core_get_evaluation_data(env)->halt = FALSE;
+        core_eval_expression(env, &head, &value);
+        VM_RELINK(base, sp);
+    }
+
+    sp = base;
+    stack[sp++] = value;
+    ip = pc + 1;
+    VM_CHECK();
+
+#if !BYTECODE_THREADED_DISPATCH
+default:
+    error_system(env, ERROR_TAG_BYTECODE, 1);
+    exit_router(env, EXIT_FAILURE);
+    goto finish;
+}
+}
+#endif
+
+copy_result:
+    result->type = stack[sp].type;
+    result->value = stack[sp].value;
+    result->begin = stack[sp].begin;
+    result->end = stack[sp].end;
+
+finish:
+    core_mem_release(env, (void *)stack, frameSize);
+    return(core_get_evaluation_data(env)->eval_error);
+
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_CHECK
+#undef VM_UNLINK
+#undef VM_RELINK
+#undef VM_INTEGERS
+#undef VM_COMPARE
+}
+
+/* =========================================
+ *****************************************
+ *       INTERNALLY VISIBLE FUNCTIONS
+ *  =========================================
+ ***************************************** */
+
+/*********************************************************
+ * _emit: Appends an instruction, growing the code array
+ *   as needed, and tracks the depth of the value stack.
+ *   Returns the index of the new instruction.
+ **********************************************************/
+static int _emit(void *env, struct bytecode_compiler *bc, int op, int type, int operand, void *value, struct core_expression *expression, int stackEffect)
+{
+    struct core_bytecode_instruction *ins;
+
+    if( bc->length == bc->capacity )
+    {
+        bc->code = (struct core_bytecode_instruction *)
+                   core_mem_realloc(env, bc->code, sizeof(struct core_bytecode_instruction) * bc->capacity,
+                                    sizeof(struct core_bytecode_instruction) * bc->capacity * 2);
+        bc->capacity *= 2;
+    }
+
+    ins = &bc->code[bc->length];
+    ins->op = (unsigned short)op;
+    ins->type = (unsigned short)type;
+    ins->operand = operand;
+    ins->value = value;
+    ins->expression = expression;
+
+    bc->depth += stackEffect;
+
+    if( bc->depth > bc->max_depth )
+    {
+        bc->max_depth = bc->depth;
+    }
+
+    return(bc->length++);
+}
+
+/*********************************************************
+ * _compile_statement: Compiles an expression whose value
+ *   becomes the value of the enclosing body. Only here
+ *   are progn and if lowered into jumps, since stopping
+ *   the loop on halt matches the body semantics. A
+ *   deffunction call is a tail call when tail is TRUE.
+ **********************************************************/
+static void _compile_statement(void *env, struct bytecode_compiler *bc, struct core_expression *expr, int tail)
+{
+    int argc;
+
+    if( expr->type == FCALL )
+    {
+        if( expr->value == (void *)core_lookup_function(env, FUNC_NAME_PROGN))
+        {
+            _compile_progn(env, bc, expr->args, tail);
+            return;
+        }
+
+        argc = core_count_args(expr->args);
+
+        if((expr->value == (void *)core_lookup_function(env, "if")) &&
+           (argc >= 2) && (argc <= 3))
+        {
+            _compile_if(env, bc, expr, tail);
+            return;
+        }
+    }
+
+#if DEFFUNCTION_CONSTRUCT
+
+    if( tail && (expr->type == PCALL))
+    {
+        _compile_call(env, bc, expr, BC_OP_TAIL_CALL, PCALL);
+        return;
+    }
+
+#endif
+
+    _compile_argument(env, bc, expr);
+}
+
+/*********************************************************
+ * _compile_progn: Compiles a sequence of actions. Every
+ *   action but the last has its value discarded.
+ **********************************************************/
+static void _compile_progn(void *env, struct bytecode_compiler *bc, struct core_expression *actions, int tail)
+{
+    if( actions == NULL )
+    {
+        _emit(env, bc, BC_OP_CONSTANT, ATOM, 0, get_false(env), NULL, 1);
+        return;
+    }
+
+    _emit(env, bc, BC_OP_PROGN, 0, 0, NULL, NULL, 0);
+
+    for( ; actions != NULL ; actions = actions->next_arg )
+    {
+        _compile_statement(env, bc, actions, tail && (actions->next_arg == NULL));
+
+        if( actions->next_arg != NULL )
+        {
+            _emit(env, bc, BC_OP_STATEMENT, 0, TRUE, NULL, actions, -1);
+        }
+        else
+        {
+            _emit(env, bc, BC_OP_STATEMENT, 0, FALSE, NULL, actions, 0);
+        }
+    }
+}
+
+/*********************************************************
+ * _compile_if: Compiles an if with its then and else
+ *   portions as statements joined by jumps.
+ **********************************************************/
+static void _compile_if(void *env, struct bytecode_compiler *bc, struct core_expression *expr, int tail)
+{
+    int jumpFalse, jumpEnd, depth;
+    struct core_expression *thenPart, *elsePart;
+
+    thenPart = expr->args->next_arg;
+    elsePart = thenPart->next_arg;
+
+    _compile_argument(env, bc, expr->args);
+    jumpFalse = _emit(env, bc, BC_OP_JUMP_FALSE, 0, 0, NULL, expr, -1);
+    depth = bc->depth;
+
+    _compile_statement(env, bc, thenPart, tail);
+    jumpEnd = _emit(env, bc, BC_OP_JUMP, 0, 0, NULL, expr, 0);
+
+    bc->code[jumpFalse].operand = bc->length;
+    bc->depth = depth;
+
+    if( elsePart != NULL )
+    {
+        _compile_statement(env, bc, elsePart, tail);
+    }
+    else
+    {
+        _emit(env, bc, BC_OP_CONSTANT, ATOM, 0, get_false(env), NULL, 1);
+    }
+
+    bc->code[jumpEnd].operand = bc->length;
+}
+
+/*********************************************************
+ * _compile_argument: Compiles an expression that pushes
+ *   exactly one value.
+ **********************************************************/
+static void _compile_argument(void *env, struct bytecode_compiler *bc, struct core_expression *expr)
+{
+    int op, type, integerOp;
+
+    switch( expr->type )
+    {
+    case STRING:
+    case ATOM:
+    case FLOAT:
+    case INTEGER:
+#if OBJECT_SYSTEM
+    case INSTANCE_NAME:
+    case INSTANCE_ADDRESS:
+#endif
+    case EXTERNAL_ADDRESS:
+        _emit(env, bc, BC_OP_CONSTANT, expr->type, 0, expr->value, expr, 1);
+        return;
+
+    case FUNCTION_ARG:
+        _emit(env, bc, BC_OP_ARGUMENT, 0, *((int *)to_bitmap(expr->value)), NULL, expr, 1);
+        return;
+
+    case FCALL:
+
+        if( _is_strict_function((struct core_function_definition *)expr->value))
+        {
+            op = _get_call_opcode((struct core_function_definition *)expr->value, &type);
+
+            if((op != BC_OP_CALL) && (core_count_args(expr->args) == 2) &&
+               ((integerOp = _get_integer_opcode((struct core_function_definition *)expr->value)) != BC_OP_CALL))
+            {
+                op = integerOp;
+            }
+
+            _compile_call(env, bc, expr, op, type);
+            return;
+        }
+
+        break;
+
+#if DEFFUNCTION_CONSTRUCT
+    case PCALL:
+        _compile_call(env, bc, expr, BC_OP_CALL, PCALL);
+        return;
+#endif
+    }
+
+    _emit(env, bc, BC_OP_EVAL, 0, 0, NULL, expr, 1);
+}
+
+/*********************************************************
+ * _compile_call: Compiles the arguments of a call in
+ *   order followed by the call itself.
+ **********************************************************/
+static void _compile_call(void *env, struct bytecode_compiler *bc, struct core_expression *expr, int op, int type)
+{
+    struct core_expression *arg;
+    int argc = 0;
+
+    for( arg = expr->args ; arg != NULL ; arg = arg->next_arg )
+    {
+        _compile_argument(env, bc, arg);
+        argc++;
+    }
+
+    _emit(env, bc, op, type, argc, expr->value, expr, 1 - argc);
+}
+
+/*********************************************************
+ * _is_strict_function: Determines whether a function
+ *   evaluates each of its arguments exactly once and only
+ *   looks at their values. Functions with their own parser
+ *   and those marked lazy with core_set_function_lazy are
+ *   left to the expression walker.
+ **********************************************************/
+static int _is_strict_function(struct core_function_definition *fptr)
+{
+    return((fptr->parser == NULL) && !fptr->lazy);
+}
+
+/*********************************************************
+ * _get_call_opcode: Selects the call instruction for a
+ *   function from its return type so the loop does not
+ *   have to inspect it on every call.
+ **********************************************************/
+static int _get_call_opcode(struct core_function_definition *fptr, int *type)
+{
+    *type = FCALL;
+
+#if PROFILING_FUNCTIONS
+    return(BC_OP_CALL);
+#else
+
+    if( !fptr->environment_aware || (fptr->context != NULL))
+    {
+        return(BC_OP_CALL);
+    }
+
+    switch( fptr->return_type )
+    {
+    case RT_VOID:
+        return(BC_OP_CALL_VOID);
+
+    case RT_BOOL:
+        return(BC_OP_CALL_BOOL);
+
+    case RT_LONG_LONG:
+        return(BC_OP_CALL_LONG_LONG);
+
+    case RT_DOUBLE:
+        return(BC_OP_CALL_DOUBLE);
+
+    case RT_STRING:
+        *type = STRING;
+        return(BC_OP_CALL_LEXEME);
+
+    case RT_ATOM:
+        *type = ATOM;
+        return(BC_OP_CALL_LEXEME);
+
+    case RT_ATOM_STRING_INST:
+    case RT_ATOM_STRING:
+    case RT_LIST:
+    case RT_INT_FLOAT:
+    case RT_UNKNOWN:
+        return(BC_OP_CALL_UNKNOWN);
+    }
+
+    return(BC_OP_CALL);
+#endif
+}
+
+/*********************************************************
+ * _get_integer_opcode: Selects the instruction that does
+ *   a two argument call of a function in place when both
+ *   arguments are integers. Returns BC_OP_CALL if there
+ *   is none.
+ **********************************************************/
+static int _get_integer_opcode(struct core_function_definition *fptr)
+{
+    if( fptr->functionPointer == VOID_FN broccoli_addition )
+    {
+        return(BC_OP_ADD);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_subtraction )
+    {
+        return(BC_OP_SUB);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_multiply )
+    {
+        return(BC_OP_MUL);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_equal )
+    {
+        return(BC_OP_EQ);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_less_than )
+    {
+        return(BC_OP_LT);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_greater_than )
+    {
+        return(BC_OP_GT);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_less_than_or_equal )
+    {
+        return(BC_OP_LE);
+    }
+    else if( fptr->functionPointer == VOID_FN broccoli_greater_than_or_equal )
+    {
+        return(BC_OP_GE);
+    }
+
+    return(BC_OP_CALL);
+}
+
+/*********************************************************
+ * _add_overflows: Determines whether x + y is outside
+ *   the range of a long long integer.
+ **********************************************************/
+static BOOLEAN _add_overflows(long long x, long long y)
+{
+    return(((y > 0) && (x > LLONG_MAX - y)) ||
+           ((y < 0) && (x < LLONG_MIN - y)));
+}
+
+/*********************************************************
+ * _sub_overflows: Determines whether x - y is outside
+ *   the range of a long long integer.
+ **********************************************************/
+static BOOLEAN _sub_overflows(long long x, long long y)
+{
+    return(((y < 0) && (x > LLONG_MAX + y)) ||
+           ((y > 0) && (x < LLONG_MIN + y)));
+}
+
+/*********************************************************
+ * _mul_overflows: Determines whether x * y is outside
+ *   the range of a long long integer.
+ **********************************************************/
+static BOOLEAN _mul_overflows(long long x, long long y)
+{
+    if((x == 0) || (y == 0))
+    {
+        return(FALSE);
+    }
+
+    if( x > 0 )
+    {
+        return((y > 0) ? (x > LLONG_MAX / y) : (y < LLONG_MIN / x));
+    }
+
+    return((y > 0) ? (x < LLONG_MIN / y) : (y < LLONG_MAX / x));
+}
+
+#endif
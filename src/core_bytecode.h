@@ -0,0 +1,74 @@
+/* Purpose: Compiles procedure bodies into a flat bytecode
+ *   and executes them with a dispatch loop.                 */
+
+#ifndef __CORE_BYTECODE_H__
+
+#define __CORE_BYTECODE_H__
+
+#ifndef __CORE_EVALUATION_H__
+#include "core_evaluation.h"
+#endif
+#ifndef __EXPRESSIONS_H__
+#include "core_expressions.h"
+#endif
+
+/*==============================================
+ * Opcodes. The order must match the dispatch
+ * table in core_bytecode_execute.
+ *==============================================*/
+#define BC_OP_CONSTANT          0
+#define BC_OP_ARGUMENT          1
+#define BC_OP_EVAL              2
+#define BC_OP_CALL              3
+#define BC_OP_CALL_VOID         4
+#define BC_OP_CALL_BOOL         5
+#define BC_OP_CALL_LONG_LONG    6
+#define BC_OP_CALL_DOUBLE       7
+#define BC_OP_CALL_LEXEME       8
+#define BC_OP_CALL_UNKNOWN      9
+#define BC_OP_ADD              10
+#define BC_OP_SUB              11
+#define BC_OP_MUL              12
+#define BC_OP_EQ               13
+#define BC_OP_LT               14
+#define BC_OP_GT               15
+#define BC_OP_LE               16
+#define BC_OP_GE               17
+#define BC_OP_TAIL_CALL        18
+#define BC_OP_PROGN            19
+#define BC_OP_STATEMENT        20
+#define BC_OP_JUMP_FALSE       21
+#define BC_OP_JUMP             22
+#define BC_OP_RETURN           23
+
+struct core_bytecode_instruction
+{
+    unsigned short          op;
+    unsigned short          type;
+    int                     operand;
+    void *                  value;
+    struct core_expression *expression;
+};
+
+struct core_bytecode
+{
+    struct core_bytecode_instruction *code;
+    int                               length;
+    int                               stack_sz;
+};
+
+#ifdef LOCALE
+#undef LOCALE
+#endif
+
+#ifdef __CORE_BYTECODE_SOURCE__
+#define LOCALE
+#else
+#define LOCALE extern
+#endif
+
+LOCALE struct core_bytecode * core_bytecode_compile(void *, struct core_expression *);
+LOCALE void                   core_bytecode_release(void *, struct core_bytecode *);
+LOCALE int                    core_bytecode_execute(void *, struct core_bytecode *, core_data_object *);
+
+#endif
@@ -527,6 +527,7 @@ BOOLEAN core_route_command(void *env, char *command, int printResult)
     struct core_expression *top;
     char *commandName;
     struct token theToken;
+    struct core_mem_region_mark region;
 
     if( command == NULL )
     {
@@ -570,7 +571,7 @@ BOOLEAN core_route_command(void *env, char *command, int printResult)
         close_string_source(env, "command");
         top = core_generate_constant(env, theToken.type, theToken.value);
         core_eval_expression(env, top, &result);
-        core_mem_return_struct(env, core_expression, top);
+        core_return_expression_node(env, top);
 
         if( printResult )
         {
@@ -636,14 +637,19 @@ BOOLEAN core_route_command(void *env, char *command, int printResult)
         }
     }
 
-    /*========================
-     * Parse a function call.
-     *========================*/
+    /*==================================================
+     * Parse a function call. The expression only lives
+     * until the command finishes, so its nodes come
+     * from a region that is dropped in one step.
+     *==================================================*/
 
+    core_mem_region_begin(env, &region);
     CommandLineData(env)->ParsingTopLevelCommand = TRUE;
     top = parse_function_body(env, "command", commandName);
     CommandLineData(env)->ParsingTopLevelCommand = FALSE;
     clear_parsed_bindings(env);
+    resolve_parsed_bindings(env, top);
+    core_mem_region_stop(env, &region);
 
     /*================================
      * Close the string input source.
@@ -657,6 +663,7 @@ BOOLEAN core_route_command(void *env, char *command, int printResult)
 
     if( top == NULL )
     {
+        core_mem_region_end(env, &region);
         return(0);
     }
 
@@ -669,7 +676,7 @@ BOOLEAN core_route_command(void *env, char *command, int printResult)
     CommandLineData(env)->EvaluatingTopLevelCommand = FALSE;
 
     core_decrement_expression(env, top);
-    core_return_expression(env, top);
+    core_mem_region_end(env, &region);
 
     if((result.type != RVOID) && printResult )
     {
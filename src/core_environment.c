@@ -315,12 +315,6 @@ BOOLEAN core_delete_environment(void *venvironment)
         rv = FALSE;
     }
 
-    free(theMemData->memory_table);
-
-#if BLOCK_MEMORY
-    ReturnAllBlocks(environment);
-#endif
-
     for( i = 0; i < MAXIMUM_ENVIRONMENT_POSITIONS; i++ )
     {
         if( environment->data[i] != NULL )
@@ -27,6 +27,7 @@
 
 #if DEFFUNCTION_CONSTRUCT
 #include "funcs_function.h"
+#include "modules_init.h"
 #endif
 
 #if DEFGENERIC_CONSTRUCT
@@ -61,6 +62,7 @@ void core_init_evaluation_data(void *env)
     struct core_external_address_type cPointer = {"C", _print_pointer, _print_pointer, NULL, _new_ext_address, NULL};
 
     core_allocate_environment_data(env, EVALUATION_DATA, sizeof(struct core_evaluation_data), _delete_evaluation_data);
+    core_get_evaluation_data(env)->function_epoch = 1;
 
     core_install_ext_address_type(env, &cPointer);
 }
@@ -77,6 +79,17 @@ static void _delete_evaluation_data(void *env)
     {
         core_mem_return_struct(env, core_external_address_type, core_get_evaluation_data(env)->ext_address_types[i]);
     }
+
+    /*=================================================
+     * Give back the names held by the function cache.
+     *=================================================*/
+    for( i = 0; i < FUNCTION_CACHE_SIZE; i++ )
+    {
+        if( core_get_evaluation_data(env)->function_cache[i].name != NULL )
+        {
+            dec_atom_count(env, core_get_evaluation_data(env)->function_cache[i].name);
+        }
+    }
 }
 
 /*************************************************************
@@ -376,6 +389,20 @@ int core_eval_expression(void *env, struct core_expression *problem, core_data_o
         ret->end = ((core_data_object_ptr)(problem->value))->end;
         break;
 
+    case DATA_OBJECT_VALUE:
+    case DATA_OBJECT_ERROR:
+        ret->type = ((core_data_object_ptr)(problem->value))->type;
+        ret->value = ((core_data_object_ptr)(problem->value))->value;
+        ret->begin = ((core_data_object_ptr)(problem->value))->begin;
+        ret->end = ((core_data_object_ptr)(problem->value))->end;
+
+        if( problem->type == DATA_OBJECT_ERROR )
+        {
+            core_set_eval_error(env, TRUE);
+        }
+
+        break;
+
     case LIST_VARIABLE:
     case SCALAR_VARIABLE:
 
@@ -766,6 +793,16 @@ void core_pass_return_value(void *env, core_data_object *vPtr)
             list_segment->depth = (short)core_get_evaluation_data(env)->eval_depth;
         }
 
+        /*==========================================
+         * A shared block already holds a reference
+         * to each of its values.
+         *==========================================*/
+
+        if( list_segment->block != NULL )
+        {
+            return;
+        }
+
         list = list_segment->cell;
 
         for( i = 0; i < list_segment->length; i++ )
@@ -785,6 +822,12 @@ static void _pass_atom(void *env, int type, void *value)
     {
     case INTEGER:
     case FLOAT:
+
+        if( is_immediate(value))
+        {
+            break;
+        }
+
     case ATOM:
     case STRING:
     case EXTERNAL_ADDRESS:
@@ -908,7 +951,7 @@ unsigned long core_hash_atom(unsigned short type, void *value, int position)
     case INSTANCE_NAME:
 #endif
     case ATOM:
-        tvalue = ((ATOM_HN *)value)->bucket;
+        tvalue = (unsigned long)((ATOM_HN *)value)->hash;
         break;
 
     default:
@@ -1054,6 +1097,67 @@ BOOLEAN core_get_function_referrence(void *env, char *name, FUNCTION_REFERENCE *
     return(FALSE);
 }
 
+/*****************************************************************
+ * core_get_cached_function_referrence: Same as
+ *   core_get_function_referrence, but remembers the result for
+ *   the name so that a function which keeps being named at run
+ *   time is only looked up once. Entries do not depend on the
+ *   calling expression, which may be a temporary one built by
+ *   the bytecode loop.
+ ******************************************************************/
+BOOLEAN core_get_cached_function_referrence(void *env, ATOM_HN *name, FUNCTION_REFERENCE *ref)
+{
+    struct core_evaluation_data *evalData = core_get_evaluation_data(env);
+    struct core_function_cache_entry *entry;
+    void *module;
+
+    module = get_current_module(env);
+    entry = &evalData->function_cache[((size_t)name >> 3) & (FUNCTION_CACHE_SIZE - 1)];
+
+    if((entry->name == name) && (entry->module == module) &&
+       (entry->epoch == evalData->function_epoch))
+    {
+        ref->next_arg = NULL;
+        ref->args = NULL;
+        ref->type = entry->type;
+        ref->value = entry->value;
+        return(TRUE);
+    }
+
+    if( !core_get_function_referrence(env, to_string(name), ref))
+    {
+        return(FALSE);
+    }
+
+    /*=================================================
+     * The name is held by the entry so that its atom
+     * cannot be freed and reused for another name.
+     *=================================================*/
+    inc_atom_count(name);
+
+    if( entry->name != NULL )
+    {
+        dec_atom_count(env, entry->name);
+    }
+
+    entry->name = name;
+    entry->module = module;
+    entry->epoch = evalData->function_epoch;
+    entry->type = ref->type;
+    entry->value = ref->value;
+
+    return(TRUE);
+}
+
+/*****************************************************************
+ * core_invalidate_function_cache: Drops every cached function
+ *   reference. Called whenever a function is removed.
+ ******************************************************************/
+void core_invalidate_function_cache(void *env)
+{
+    core_get_evaluation_data(env)->function_epoch++;
+}
+
 /******************************************************
  * PrintCAddress:
  *******************************************************/
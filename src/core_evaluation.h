@@ -86,18 +86,18 @@ typedef struct core_data_entity * core_data_entity_object_pt;
 #define core_set_data_ptr_end(target, val)     ((target)->end = (long)((val) - 1))
 
 #define core_convert_data_ptr_to_string(target)          (((struct atom_hash_node *)((target)->value))->contents)
-#define core_convert_data_ptr_to_double(target)          (((struct float_hash_node *)((target)->value))->contents)
-#define core_convert_data_ptr_to_float(target)           ((float)(((struct float_hash_node *)((target)->value))->contents))
-#define core_convert_data_ptr_to_long(target)            (((struct integer_hash_node *)((target)->value))->contents)
-#define core_convert_data_ptr_to_integer(target)         ((int)(((struct integer_hash_node *)((target)->value))->contents))
+#define core_convert_data_ptr_to_double(target)          to_double((target)->value)
+#define core_convert_data_ptr_to_float(target)           ((float)to_double((target)->value))
+#define core_convert_data_ptr_to_long(target)            to_long((target)->value)
+#define core_convert_data_ptr_to_integer(target)         ((int)to_long((target)->value))
 #define core_convert_data_ptr_to_pointer(target)         ((target)->value)
 #define core_convert_data_ptr_to_ext_address(target)     (((struct external_address_hash_node *)((target)->value))->address)
 
 #define core_convert_data_to_string(target)          (((struct atom_hash_node *)((target).value))->contents)
-#define core_convert_data_to_double(target)          (((struct float_hash_node *)((target).value))->contents)
-#define core_convert_data_to_float(target)           ((float)(((struct float_hash_node *)((target).value))->contents))
-#define core_convert_data_to_long(target)            (((struct integer_hash_node *)((target).value))->contents)
-#define core_convert_data_to_integer(target)         ((int)(((struct integer_hash_node *)((target).value))->contents))
+#define core_convert_data_to_double(target)          to_double((target).value)
+#define core_convert_data_to_float(target)           ((float)to_double((target).value))
+#define core_convert_data_to_long(target)            to_long((target).value)
+#define core_convert_data_to_integer(target)         ((int)to_long((target).value))
 #define core_convert_data_to_pointe(target)          ((target).value)
 #define core_convert_data_to_ext_address(target)     (((struct external_address_hash_node *)((target).value))->address))
 
@@ -113,6 +113,7 @@ typedef struct core_data_entity * core_data_entity_object_pt;
 #define core_get_next_arg(ep)          (ep->next_arg)
 
 #define MAXIMUM_PRIMITIVES             150
+#define FUNCTION_CACHE_SIZE            64
 #define MAXIMUM_EXTERNAL_ADDRESS_TYPES 10
 #define EVALUATION_DATA                44
 #define BITS_PER_BYTE                  8
@@ -125,6 +126,22 @@ typedef struct core_data_entity * core_data_entity_object_pt;
 #define core_bitmap_set(map, id)   core_bit_set(map[(id) / BITS_PER_BYTE], (id) % BITS_PER_BYTE)
 #define core_bitmap_clear(map, id) core_bit_clear(map[(id) / BITS_PER_BYTE], (id) % BITS_PER_BYTE)
 
+/*==================================================
+ * Cache for functions that are looked up by name at
+ * run time, such as the target of call. An entry
+ * holds its name and is only good for the module
+ * and the epoch it was filled in; removing a
+ * function moves the epoch on.
+ *==================================================*/
+struct core_function_cache_entry
+{
+    struct atom_hash_node * name;
+    void *                  module;
+    unsigned long           epoch;
+    unsigned short          type;
+    void *                  value;
+};
+
 struct core_evaluation_data
 {
     struct core_expression *           current_expression;
@@ -134,6 +151,8 @@ struct core_evaluation_data
     int                                address_type_count;
     struct core_data_entity *          primitives[MAXIMUM_PRIMITIVES];
     struct core_external_address_type *ext_address_types[MAXIMUM_EXTERNAL_ADDRESS_TYPES];
+    struct core_function_cache_entry   function_cache[FUNCTION_CACHE_SIZE];
+    unsigned long                      function_epoch;
 };
 
 #define core_get_evaluation_data(env) ((struct core_evaluation_data *)core_get_environment_data(env, EVALUATION_DATA))
@@ -169,6 +188,8 @@ LOCALE int                      core_install_ext_address_type(void *, struct cor
 LOCALE void                     core_copy_data(core_data_object *, core_data_object *);
 LOCALE struct core_expression * core_convert_expression_to_function(void *, char *);
 LOCALE BOOLEAN                  core_get_function_referrence(void *, char *, FUNCTION_REFERENCE *);
+LOCALE BOOLEAN                  core_get_cached_function_referrence(void *, struct atom_hash_node *, FUNCTION_REFERENCE *);
+LOCALE void                     core_invalidate_function_cache(void *);
 
 #define ERROR_TAG_EVALUATION            "Evaluation Error "
 #define ERROR_MSG_FUNC_NOT_FOUND        "Function not found "
@@ -20,6 +20,7 @@
 #include "core_evaluation.h"
 #include "funcs_comparison.h"
 #include "funcs_logic.h"
+#include "funcs_math_basic.h"
 
 #include "core_expressions.h"
 
@@ -49,6 +50,7 @@ void core_init_expression_data(void *env)
     core_allocate_environment_data(env, EXPRESSION_DATA_INDEX, sizeof(struct core_expression_data), _delete_expression_data);
 
     _init_expression_pointers(env);
+    init_expression_optimizer(env);
 
     core_get_expression_data(env)->expression_hash_table = (EXPRESSION_HASH **)
                                                            core_mem_alloc_no_init(env, (int)(sizeof(EXPRESSION_HASH *) * EXPRESSION_HASH_SZ));
@@ -98,6 +100,8 @@ void _init_expression_pointers(void *env)
     core_get_expression_data(env)->fn_equal = (void *)core_lookup_function(env, FUNC_NAME_EQUAL);
     core_get_expression_data(env)->fn_not_equal = (void *)core_lookup_function(env, FUNC_NAME_NOT_EQUAL);
     core_get_expression_data(env)->fn_not = (void *)core_lookup_function(env, FUNC_NAME_NOT);
+    core_get_expression_data(env)->fn_add = (void *)core_lookup_function(env, FUNC_NAME_ADD);
+    core_get_expression_data(env)->fn_multiply = (void *)core_lookup_function(env, FUNC_NAME_MULT);
 
     if((core_get_expression_data(env)->fn_and == NULL) || (core_get_expression_data(env)->fn_or == NULL) ||
        (core_get_expression_data(env)->fn_equal == NULL) || (core_get_expression_data(env)->fn_not_equal == NULL) || (core_get_expression_data(env)->fn_not == NULL))
@@ -242,10 +246,41 @@ void core_return_expression(void *env, struct core_expression *waste)
 
         tmp = waste;
         waste = waste->next_arg;
-        core_mem_return_struct(env, core_expression, tmp);
+        core_return_expression_node(env, tmp);
     }
 }
 
+/***********************************************
+ * core_get_expression_node: Allocates a single
+ *   expression node. Nodes built while a memory
+ *   region is active come from the region and
+ *   are released all at once when it ends.
+ ***********************************************/
+struct core_expression *core_get_expression_node(void *env)
+{
+    if( core_mem_region_is_active(env))
+    {
+        return((struct core_expression *)core_mem_region_alloc(env, sizeof(struct core_expression)));
+    }
+
+    return(core_mem_get_struct(env, core_expression));
+}
+
+/***********************************************
+ * core_return_expression_node: Returns a single
+ *   expression node. Region nodes are left for
+ *   the region to release.
+ ***********************************************/
+void core_return_expression_node(void *env, struct core_expression *node)
+{
+    if( core_mem_region_contains(env, (void *)node))
+    {
+        return;
+    }
+
+    core_mem_return_struct(env, core_expression, node);
+}
+
 /***************************************************
  *  NAME         : FindHashedExpression
  *  DESCRIPTION  : Determines if a given expression
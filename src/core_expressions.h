@@ -64,6 +64,8 @@ struct core_expression_data
     void *            fn_equal;
     void *            fn_not_equal;
     void *            fn_not;
+    void *            fn_add;
+    void *            fn_multiply;
     EXPRESSION_HASH **expression_hash_table;
     SAVED_CONTEXTS *  saved_contexts;
     int               return_context;
@@ -88,6 +90,8 @@ struct core_expression_data
 #endif
 
 LOCALE void                                        core_return_expression(void *, struct core_expression *);
+LOCALE struct core_expression                    * core_get_expression_node(void *);
+LOCALE void                                        core_return_expression_node(void *, struct core_expression *);
 LOCALE void                                        core_increment_expression(void *, struct core_expression *);
 LOCALE void                                        core_decrement_expression(void *, struct core_expression *);
 LOCALE struct core_expression        *             core_pack_expression(void *, struct core_expression *);
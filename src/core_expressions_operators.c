@@ -284,7 +284,7 @@ struct core_expression *core_generate_constant(void *env, unsigned short type, v
 {
     struct core_expression *top;
 
-    top = core_mem_get_struct(env, core_expression);
+    top = core_get_expression_node(env);
     top->next_arg = NULL;
     top->args = NULL;
     top->type = type;
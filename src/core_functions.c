@@ -171,6 +171,8 @@ int _define_function(void *env, char *name, int returnType, int (*pointer)(void
     newFunction->parser = NULL;
     newFunction->overloadable = TRUE;
     newFunction->sequential_usage_allowed = TRUE;
+    newFunction->pure = FALSE;
+    newFunction->lazy = FALSE;
     newFunction->environment_aware = (short)environmentAware;
     newFunction->ext_data = NULL;
     newFunction->context = context;
@@ -209,6 +211,7 @@ int core_undefine_function(void *env, char *functionName)
 
             ext_clear_data(env, fPtr->ext_data);
             core_mem_return_struct(env, core_function_definition, fPtr);
+            core_invalidate_function_cache(env);
             return(TRUE);
         }
 
@@ -303,6 +306,49 @@ int core_set_function_overload(void *env, char *functionName, int seqp, int ovlp
     return(TRUE);
 }
 
+/****************************************************************
+ * core_set_function_pure: Marks a system function as pure, i.e.
+ * its value depends only on its arguments and calling it has no
+ * side effects, so a call with constant arguments may be folded
+ * into its value when an expression is parsed.
+ *****************************************************************/
+int core_set_function_pure(void *env, char *functionName, int pure)
+{
+    struct core_function_definition *fdPtr;
+
+    fdPtr = core_lookup_function(env, functionName);
+
+    if( fdPtr == NULL )
+    {
+        return(FALSE);
+    }
+
+    fdPtr->pure = (short)(pure ? TRUE : FALSE);
+    return(TRUE);
+}
+
+/****************************************************************
+ * core_set_function_lazy: Marks a system function as lazy, i.e.
+ * it decides itself when and how often its arguments are
+ * evaluated, or reads their expressions instead of their values,
+ * so its calls cannot be compiled to bytecode with the arguments
+ * evaluated up front.
+ *****************************************************************/
+int core_set_function_lazy(void *env, char *functionName, int lazy)
+{
+    struct core_function_definition *fdPtr;
+
+    fdPtr = core_lookup_function(env, functionName);
+
+    if( fdPtr == NULL )
+    {
+        return(FALSE);
+    }
+
+    fdPtr->lazy = (short)(lazy ? TRUE : FALSE);
+    return(TRUE);
+}
+
 /********************************************************
  * core_arg_type_of: Returns a descriptive string for
  *   a function argument type (used by DefineFunction2).
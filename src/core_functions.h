@@ -24,6 +24,8 @@ struct core_function_definition
     char *                           restrictions;
     short int                        overloadable;
     short int                        sequential_usage_allowed;
+    short int                        pure;
+    short int                        lazy;
     short int                        environment_aware;
     short int                        id;
     struct core_function_definition *next;
@@ -78,6 +80,8 @@ LOCALE void core_init_function_data(void *);
 LOCALE int core_define_function(void *, char *, int, int(*) (void *), char *, char *);
 LOCALE int core_add_function_parser(void *, char *, struct core_expression *(*)(void *, struct core_expression *, char *));
 LOCALE int                                   core_set_function_overload(void *, char *, int, int);
+LOCALE int                                   core_set_function_pure(void *, char *, int);
+LOCALE int                                   core_set_function_lazy(void *, char *, int);
 LOCALE struct core_function_definition     * core_get_function_list(void *);
 LOCALE struct core_function_definition     * core_lookup_function(void *, char *);
 LOCALE int                                   core_get_function_arg_restriction(struct core_function_definition *, int);
@@ -28,6 +28,9 @@
 #include "parser_flow_control.h"
 #include "router.h"
 #include "core_gc.h"
+#if BYTECODE_FUNCTIONS
+#include "core_bytecode.h"
+#endif
 
 #define __CORE_WILDCARDS_SOURCE__
 #include "core_functions_util.h"
@@ -66,6 +69,7 @@ static void    _release_function_args(void *);
 static int _lookup_function_arg(ATOM_HN *, core_expression_object *, ATOM_HN *);
 static int _release_function_binding(void *, core_expression_object *, int(*) (void *, core_expression_object *, void *), void *);
 static core_expression_object * _pack_function_actions(void *, core_expression_object *);
+static void                     _eval_function_body(void *, struct module_definition *, core_expression_object *, struct core_bytecode *, int, core_data_object *, void(*) (void *), int(*) (void *, core_expression_object *, core_data_object *));
 static BOOLEAN                  _dummy_function_call(void *, void *, core_data_object *);
 
 /* =========================================
@@ -385,6 +389,7 @@ core_expression_object *core_parse_function_actions(void *env, char *bodytype, c
      *  packed into a contiguous array to save on memory overhead.  The
      *  intermediate parsed bind names are freed to avoid tying up memory.
      *  ======================================================================= */
+    optimize_expression(env, actions);
     actions = _pack_function_actions(env, actions);
     pactions = core_pack_expression(env, actions);
     core_return_expression(env, actions);
@@ -497,12 +502,12 @@ int core_replace_function_variable(void *env, char *bodytype, core_expression_ob
 
                     if( altcode == 0 )
                     {
-                        core_mem_return_struct(env, core_expression, altvarexp);
+                        core_return_expression_node(env, altvarexp);
                         altvarexp = NULL;
                     }
                     else if( altcode == -1 )
                     {
-                        core_mem_return_struct(env, core_expression, altvarexp);
+                        core_return_expression_node(env, altvarexp);
                         return(TRUE);
                     }
                 }
@@ -550,7 +555,7 @@ int core_replace_function_variable(void *env, char *bodytype, core_expression_ob
                 boundPosn = find_parsed_binding(env, (ATOM_HN *)actions->args->value);
                 actions->value = store_bitmap(env, (void *)&boundPosn, (int)sizeof(BOOLEAN));
                 arg_lvl = actions->args->next_arg;
-                core_mem_return_struct(env, core_expression, actions->args);
+                core_return_expression_node(env, actions->args);
                 actions->args = arg_lvl;
             }
         }
@@ -837,8 +842,77 @@ core_expression_object *core_garner_generic_args(void *env)
  *  NOTES        : None
  ***********************************************************/
 void core_eval_function_actions(void *env, struct module_definition *theModule, core_expression_object *actions, int lvarcnt, core_data_object *result, void (*crtproc)(void *))
+{
+    _eval_function_body(env, theModule, actions, NULL, lvarcnt, result, crtproc, core_eval_expression);
+}
+
+#if BYTECODE_FUNCTIONS
+
+/***********************************************************
+ *  NAME         : core_eval_function_bytecode
+ *  DESCRIPTION  : Evaluates the actions of a deffunction
+ *              using their compiled bytecode.
+ *  INPUTS       : 1) The module where the actions should be
+ *                 executed
+ *              2) The actions (linked by next_arg fields)
+ *              3) The bytecode compiled from the actions
+ *                 (can be NULL to use the actions)
+ *              4) The number of local variables to reserve
+ *                 space for.
+ *              5) A buffer to hold the result of evaluating
+ *                 the actions.
+ *              6) A function which prints out the name of
+ *                 the currently executing body for error
+ *                 messages (can be NULL).
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Allocates and deallocates space for
+ *              local variable array.
+ *  NOTES        : None
+ ***********************************************************/
+void core_eval_function_bytecode(void *env, struct module_definition *theModule, core_expression_object *actions, struct core_bytecode *bytecode, int lvarcnt, core_data_object *result, void (*crtproc)(void *))
+{
+    _eval_function_body(env, theModule, actions, bytecode, lvarcnt, result, crtproc, core_eval_expression);
+}
+
+#else
+
+/***********************************************************
+ *  NAME         : core_eval_function_walker
+ *  DESCRIPTION  : Evaluates the actions of a deffunction
+ *              by walking them with the given evaluator.
+ *  INPUTS       : 1-5) See core_eval_function_actions
+ *              6) The function which evaluates the
+ *                 actions in place of core_eval_expression
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Allocates and deallocates space for
+ *              local variable array.
+ *  NOTES        : Lets deffunctions make their tail calls
+ *              without the bytecode loop
+ ***********************************************************/
+void core_eval_function_walker(void *env, struct module_definition *theModule, core_expression_object *actions, int lvarcnt, core_data_object *result, void (*crtproc)(void *), int (*evaluate)(void *, core_expression_object *, core_data_object *))
+{
+    _eval_function_body(env, theModule, actions, NULL, lvarcnt, result, crtproc, evaluate);
+}
+
+#endif
+
+/***********************************************************
+ *  NAME         : _eval_function_body
+ *  DESCRIPTION  : Sets up the local variable array and
+ *              module for a procedure body and evaluates
+ *              it, either by walking the actions or by
+ *              running their bytecode.
+ *  INPUTS       : See core_eval_function_bytecode and
+ *              core_eval_function_walker
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Allocates and deallocates space for
+ *              local variable array.
+ *  NOTES        : None
+ ***********************************************************/
+static void _eval_function_body(void *env, struct module_definition *theModule, core_expression_object *actions, struct core_bytecode *bytecode, int lvarcnt, core_data_object *result, void (*crtproc)(void *), int (*evaluate)(void *, core_expression_object *, core_data_object *))
 {
     core_data_object *oldLocalVarArray;
+    int evalError;
     register int i;
     struct module_definition *oldModule;
     core_expression_object *oldActions;
@@ -872,7 +946,19 @@ void core_eval_function_actions(void *env, struct module_definition *theModule,
     oldActions = core_get_function_primitive_data(env)->actions;
     core_get_function_primitive_data(env)->actions = actions;
 
-    if( core_eval_expression(env, actions, result))
+#if BYTECODE_FUNCTIONS
+
+    if( bytecode != NULL )
+    {
+        evalError = core_bytecode_execute(env, bytecode, result);
+    }
+    else
+#endif
+    {
+        evalError = (*evaluate)(env, actions, result);
+    }
+
+    if( evalError )
     {
         result->type = ATOM;
         result->value = get_false(env);
@@ -1431,7 +1517,7 @@ static core_expression_object *_pack_function_actions(void *env, core_expression
     {
         tmp = actions;
         actions = actions->args;
-        core_mem_return_struct(env, core_expression, tmp);
+        core_return_expression_node(env, tmp);
     }
 
     return(actions);
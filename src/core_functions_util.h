@@ -1,6 +1,8 @@
 #ifndef __CORE_WILDCARDS_H__
 #define __CORE_WILDCARDS_H__
 
+struct core_bytecode;
+
 #ifndef __EXPRESSIONS_H__
 #include "core_expressions.h"
 #endif
@@ -93,6 +95,11 @@ LOCALE core_expression_object *core_garner_generic_args(void *);
 #endif
 
 LOCALE void core_eval_function_actions(void *, struct module_definition *, core_expression_object *, int, core_data_object *, void(*) (void *));
+#if BYTECODE_FUNCTIONS
+LOCALE void core_eval_function_bytecode(void *, struct module_definition *, core_expression_object *, struct core_bytecode *, int, core_data_object *, void(*) (void *));
+#else
+LOCALE void core_eval_function_walker(void *, struct module_definition *, core_expression_object *, int, core_data_object *, void(*) (void *), int(*) (void *, core_expression_object *, core_data_object *));
+#endif
 LOCALE void core_print_function_args(void *, char *);
 LOCALE void core_garner_optional_args(void *, core_data_object *, int);
 
@@ -184,6 +184,8 @@ void core_gc_periodic_cleanup(void *env, BOOLEAN cleanupAllDepths, BOOLEAN useHe
         core_get_evaluation_data(env)->eval_depth = -1;
     }
 
+    core_get_gc_data(env)->collections++;
+
     /*=============================================
      * Free up list values no longer in use.
      *=============================================*/
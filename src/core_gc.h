@@ -42,6 +42,7 @@ struct core_gc_data
     long                           generational_item_sz;
     long                           generational_item_count_max;
     long                           generational_item_sz_max;
+    long                           collections;
     void                           (*fn_yield_time)(void);
     int                            last_eval_depth;
     struct core_gc_tracked_memory *tracked_memory;
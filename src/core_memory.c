@@ -22,7 +22,9 @@
 #include <malloc.h>
 #endif
 
-#define STRICT_ALIGN_SIZE sizeof(double)
+#define MEM_SLAB_HEADER_SZ ((((sizeof(struct core_mem_slab) - 1) / MEM_ALIGN_SIZE) + 1) * MEM_ALIGN_SIZE)
+
+#define MEM_REGION_HEADER_SZ ((((sizeof(struct core_mem_region_chunk) - 1) / MEM_ALIGN_SIZE) + 1) * MEM_ALIGN_SIZE)
 
 #define _special_malloc(sz) malloc((STD_SIZE)sz)
 #define _special_free(ptr)  free(ptr)
@@ -31,71 +33,131 @@
  * LOCAL FUNCTION PROTOTYPES
  ***************************************/
 
-#if BLOCK_MEMORY
-static int InitializeBlockMemory(void *, unsigned int);
-static int AllocateBlock(void *, struct core_mem_block *, unsigned int);
-static void AllocateChunk(void *, struct core_mem_block *, struct core_mem_chunk *, size_t);
-#endif
+static void * _system_alloc(void *, size_t);
+static void   _system_free(void *, void *, size_t);
+static void * _allocate_slab(void *, struct core_mem_class *, int);
+static long   _release_empty_slabs(void *, int);
+static int    _compare_slabs(const void *, const void *);
+static long   _find_slab(struct core_mem_slab **, long, void *);
+static void * _next_region_chunk(void *, size_t);
+static long   _release_region_chunks(void *);
 
 /*******************************************
  * core_mem_init_memory: Sets up memory tables.
  ********************************************/
 void core_mem_init_memory(void *env)
 {
-    int i;
-
     core_allocate_environment_data(env, MEMORY_DATA_INDEX, sizeof(struct core_mem_memory), NULL);
 
     core_mem_get_memory_data(env)->fn_out_of_memory = core_mem_fn_out_of_memory;
+}
 
-    core_mem_get_memory_data(env)->memory_table = (struct core_mem_ptr **)malloc((STD_SIZE)(sizeof(struct core_mem_ptr *) *MEM_TABLE_SIZE));
+/**************************************************
+ * core_mem_alloc: A generic memory allocation function.
+ *   Small requests are served from the size classes.
+ ***************************************************/
+void *core_mem_alloc(void *env, size_t size)
+{
+    if( size < sizeof(char *))
+    {
+        size = sizeof(char *);
+    }
 
-    if( core_mem_get_memory_data(env)->memory_table == NULL )
+    if( size < MEM_TABLE_SIZE )
     {
-        error_print_id(env, "MEMORY", 1, TRUE);
-        print_router(env, WERROR, "Out of memory.\n");
-        exit_router(env, EXIT_FAILURE);
+        return(core_mem_alloc_small(env, size));
+    }
+
+    core_mem_get_memory_data(env)->allocations++;
+    core_mem_get_memory_data(env)->allocated += (long)size;
+
+    return(_system_alloc(env, size));
+}
+
+/**************************************************
+ * core_mem_alloc_small: Returns an object from the
+ *   size class for a request smaller than
+ *   MEM_TABLE_SIZE, starting a new slab if the
+ *   class has nothing left.
+ ***************************************************/
+void *core_mem_alloc_small(void *env, size_t size)
+{
+    struct core_mem_class *memClass;
+    struct core_mem_ptr *memPtr;
+    int classIndex;
+    size_t objectSize;
+
+    classIndex = (int)core_mem_class_of(size);
+
+    if( classIndex == 0 )
+    {
+        classIndex = 1;
     }
 
-    for( i = 0; i < MEM_TABLE_SIZE; i++ )
+    memClass = &core_mem_get_memory_data(env)->classes[classIndex];
+    memClass->in_use++;
+    core_mem_get_memory_data(env)->allocations++;
+    core_mem_get_memory_data(env)->allocated += (long)size;
+
+    if( memClass->free_list != NULL )
     {
-        core_mem_get_memory_data(env)->memory_table[i] = NULL;
+        memPtr = memClass->free_list;
+        memClass->free_list = memPtr->next;
+        return((void *)memPtr);
     }
+
+    objectSize = (size_t)classIndex * MEM_ALIGN_SIZE;
+
+    if((size_t)(memClass->bump_end - memClass->bump) >= objectSize )
+    {
+        memPtr = (struct core_mem_ptr *)memClass->bump;
+        memClass->bump += objectSize;
+        return((void *)memPtr);
+    }
+
+    return(_allocate_slab(env, memClass, classIndex));
 }
 
 /**************************************************
- * core_mem_alloc: A generic memory allocation function.
+ * _allocate_slab: Gets a new slab for a size class
+ *   and returns its first object. The rest of the
+ *   slab is handed out by the bump pointer.
  ***************************************************/
-void *core_mem_alloc(void *env, size_t size)
+static void *_allocate_slab(void *env, struct core_mem_class *memClass, int classIndex)
 {
+    struct core_mem_slab *slab;
+    size_t objectSize;
     char *memPtr;
 
-#if   BLOCK_MEMORY
-    memPtr = (char *)RequestChunk(env, size);
+    objectSize = (size_t)classIndex * MEM_ALIGN_SIZE;
+    slab = (struct core_mem_slab *)_system_alloc(env, MEM_SLAB_SIZE);
 
-    if( memPtr == NULL )
+    if( slab == NULL )
     {
-        core_mem_release_count(env, (long)((size * 5 > 4096) ? size * 5 : 4096), FALSE);
-        memPtr = (char *)RequestChunk(env, size);
+        memClass->in_use--;
+        return(NULL);
+    }
 
-        if( memPtr == NULL )
-        {
-            core_mem_release_count(env, -1L, TRUE);
-            memPtr = (char *)RequestChunk(env, size);
+    slab->next = memClass->slabs;
+    memClass->slabs = slab;
+    memClass->slab_count++;
 
-            while( memPtr == NULL )
-            {
-                if((*core_mem_get_memory_data(env)->fn_out_of_memory)(env, (unsigned long)size))
-                {
-                    return(NULL);
-                }
+    memPtr = ((char *)slab) + MEM_SLAB_HEADER_SZ;
+    memClass->bump = memPtr + objectSize;
+    memClass->bump_end = memPtr + ((MEM_SLAB_SIZE - MEM_SLAB_HEADER_SZ) / objectSize) * objectSize;
 
-                memPtr = (char *)RequestChunk(env, size);
-            }
-        }
-    }
+    return((void *)memPtr);
+}
+
+/**************************************************
+ * _system_alloc: Gets memory from malloc, releasing
+ *   empty slabs and then calling the out of memory
+ *   function if malloc fails.
+ ***************************************************/
+static void *_system_alloc(void *env, size_t size)
+{
+    char *memPtr;
 
-#else
     memPtr = (char *)malloc(size);
 
     if( memPtr == NULL )
@@ -120,8 +182,6 @@ void *core_mem_alloc(void *env, size_t size)
         }
     }
 
-#endif
-
     core_mem_get_memory_data(env)->amount += (long)size;
     core_mem_get_memory_data(env)->calls++;
 
@@ -149,26 +209,42 @@ int core_mem_fn_out_of_memory(void *env, size_t size)
 
 /***************************************************
  * core_mem_free: A generic memory deallocation function.
+ *   Small objects go back to their size class.
  ****************************************************/
 int core_mem_free(void *env, void *waste, size_t size)
 {
-#if BLOCK_MEMORY
+    struct core_mem_class *memClass;
+    struct core_mem_ptr *memPtr;
 
-    if( ReturnChunk(env, waste, size) == FALSE )
+    if( size < sizeof(char *))
     {
-        error_print_id(env, "MEMORY", 2, TRUE);
-        print_router(env, WERROR, "Release error in genfree.\n");
-        return(-1);
+        size = sizeof(char *);
     }
 
-#else
+    if( size >= MEM_TABLE_SIZE )
+    {
+        _system_free(env, waste, size);
+        return(0);
+    }
+
+    memClass = core_mem_class(env, size);
+    memPtr = (struct core_mem_ptr *)waste;
+    memPtr->next = memClass->free_list;
+    memClass->free_list = memPtr;
+    memClass->in_use--;
+
+    return(0);
+}
+
+/***************************************************
+ * _system_free: Returns memory to the system.
+ ****************************************************/
+static void _system_free(void *env, void *waste, size_t size)
+{
     free(waste);
-#endif
 
     core_mem_get_memory_data(env)->amount -= (long)size;
     core_mem_get_memory_data(env)->calls--;
-
-    return(0);
 }
 
 /*****************************************************
@@ -204,13 +280,14 @@ void *core_mem_realloc(void *env, void *oldaddr, size_t oldsz, size_t newsz)
 
 /**********************************
  * core_mem_release_count: C access routine
- *   for the release-mem command.
+ *   for the release-mem command. Returns the
+ *   slabs that hold no objects in use to the
+ *   system, largest classes first, until more
+ *   than maximum bytes have been released.
  ***********************************/
 long int core_mem_release_count(void *env, long int maximum, int printMessage)
 {
-    struct core_mem_ptr *tmpPtr, *memPtr;
     int i;
-    long int returns = 0;
     long int amount = 0;
 
     if( printMessage == TRUE )
@@ -218,26 +295,12 @@ long int core_mem_release_count(void *env, long int maximum, int printMessage)
         print_router(env, WDIALOG, "\n*** DEALLOCATING MEMORY ***\n");
     }
 
-    for( i = (MEM_TABLE_SIZE - 1) ; i >= (int)sizeof(char *) ; i-- )
+    amount += _release_region_chunks(env);
+
+    for( i = MEM_CLASS_COUNT - 1 ; i > 0 ; i-- )
     {
         core_gc_yield_time(env);
-        memPtr = core_mem_get_memory_data(env)->memory_table[i];
-
-        while( memPtr != NULL )
-        {
-            tmpPtr = memPtr->next;
-            core_mem_free(env, (void *)memPtr, (unsigned)i);
-            memPtr = tmpPtr;
-            amount += i;
-            returns++;
-
-            if((returns % 100) == 0 )
-            {
-                core_gc_yield_time(env);
-            }
-        }
-
-        core_mem_get_memory_data(env)->memory_table[i] = NULL;
+        amount += _release_empty_slabs(env, i);
 
         if((amount > maximum) && (maximum > 0))
         {
@@ -259,113 +322,217 @@ long int core_mem_release_count(void *env, long int maximum, int printMessage)
 }
 
 /****************************************************
- * core_mem_alloc_and_init: Allocates memory and sets all bytes to zero.
+ * _release_empty_slabs: Frees the slabs of a size
+ *   class whose objects are all on the free list or
+ *   still unused behind the bump pointer. Returns
+ *   the number of bytes released.
  *****************************************************/
-void *core_mem_alloc_and_init(void *env, size_t size)
+static long _release_empty_slabs(void *env, int classIndex)
 {
-    struct core_mem_ptr *memPtr;
-    char *tmpPtr;
-    size_t i;
+    struct core_mem_class *memClass;
+    struct core_mem_slab **slabs, *slab;
+    struct core_mem_ptr *memPtr, *nextPtr;
+    long *counts, i, found, capacity, bumpSlab = -1;
+    long amount = 0;
+    size_t objectSize;
+
+    memClass = &core_mem_get_memory_data(env)->classes[classIndex];
 
-    if( size < (long)sizeof(char *))
+    if( memClass->slab_count == 0 )
     {
-        size = sizeof(char *);
+        return(0);
     }
 
-    if( size >= MEM_TABLE_SIZE )
+    /*=============================================
+     * The bookkeeping arrays come straight from
+     * malloc since this may run when memory is
+     * short. Nothing is released if they can't
+     * be allocated.
+     *=============================================*/
+
+    slabs = (struct core_mem_slab **)malloc(sizeof(struct core_mem_slab *) * (size_t)memClass->slab_count);
+    counts = (long *)malloc(sizeof(long) * (size_t)memClass->slab_count);
+
+    if((slabs == NULL) || (counts == NULL))
     {
-        tmpPtr = (char *)core_mem_alloc(env, (unsigned)size);
+        free(slabs);
+        free(counts);
+        return(0);
+    }
 
-        for( i = 0 ; i < size ; i++ )
+    for( slab = memClass->slabs, i = 0; slab != NULL; slab = slab->next, i++ )
+    {
+        slabs[i] = slab;
+        counts[i] = 0;
+    }
+
+    qsort(slabs, (size_t)memClass->slab_count, sizeof(struct core_mem_slab *), _compare_slabs);
+
+    /*============================================
+     * Count the free objects held in each slab.
+     *============================================*/
+
+    objectSize = (size_t)classIndex * MEM_ALIGN_SIZE;
+    capacity = (long)((MEM_SLAB_SIZE - MEM_SLAB_HEADER_SZ) / objectSize);
+
+    for( memPtr = memClass->free_list; memPtr != NULL; memPtr = memPtr->next )
+    {
+        found = _find_slab(slabs, memClass->slab_count, (void *)memPtr);
+
+        if( found >= 0 )
         {
-            tmpPtr[i] = '\0';
+            counts[found]++;
         }
+    }
+
+    if( memClass->bump != NULL )
+    {
+        bumpSlab = _find_slab(slabs, memClass->slab_count, (void *)(memClass->bump - 1));
 
-        return((void *)tmpPtr);
+        if( bumpSlab >= 0 )
+        {
+            counts[bumpSlab] += (long)((size_t)(memClass->bump_end - memClass->bump) / objectSize);
+        }
     }
 
-    memPtr = (struct core_mem_ptr *)core_mem_get_memory_data(env)->memory_table[size];
+    /*===============================================
+     * Drop the free objects that live in an empty
+     * slab from the free list, then free the slabs.
+     *===============================================*/
 
-    if( memPtr == NULL )
+    memPtr = memClass->free_list;
+    memClass->free_list = NULL;
+
+    while( memPtr != NULL )
     {
-        tmpPtr = (char *)core_mem_alloc(env, (unsigned)size);
+        nextPtr = memPtr->next;
+        found = _find_slab(slabs, memClass->slab_count, (void *)memPtr);
 
-        for( i = 0 ; i < size ; i++ )
+        if((found < 0) || (counts[found] != capacity))
         {
-            tmpPtr[i] = '\0';
+            memPtr->next = memClass->free_list;
+            memClass->free_list = memPtr;
         }
 
-        return((void *)tmpPtr);
+        memPtr = nextPtr;
     }
 
-    core_mem_get_memory_data(env)->memory_table[size] = memPtr->next;
+    if((bumpSlab >= 0) && (counts[bumpSlab] == capacity))
+    {
+        memClass->bump = NULL;
+        memClass->bump_end = NULL;
+    }
 
-    tmpPtr = (char *)memPtr;
+    found = memClass->slab_count;
+    memClass->slabs = NULL;
+    memClass->slab_count = 0;
 
-    for( i = 0 ; i < size ; i++ )
+    for( i = 0; i < found; i++ )
     {
-        tmpPtr[i] = '\0';
+        if( counts[i] == capacity )
+        {
+            _system_free(env, (void *)slabs[i], MEM_SLAB_SIZE);
+            amount += MEM_SLAB_SIZE;
+        }
+        else
+        {
+            slabs[i]->next = memClass->slabs;
+            memClass->slabs = slabs[i];
+            memClass->slab_count++;
+        }
     }
 
-    return((void *)tmpPtr);
+    free(slabs);
+    free(counts);
+
+    return(amount);
 }
 
-/****************************************************
- * core_mem_alloc_no_init: Allocates memory and does not initialize it.
- *****************************************************/
-void *core_mem_alloc_no_init(void *env, size_t size)
+/***************************************************
+ * _compare_slabs: qsort comparison that orders
+ *   slabs by address.
+ ****************************************************/
+static int _compare_slabs(const void *first, const void *second)
 {
-    struct core_mem_ptr *memPtr;
+    size_t a = (size_t)*((struct core_mem_slab * const *)first);
+    size_t b = (size_t)*((struct core_mem_slab * const *)second);
 
-    if( size < sizeof(char *))
+    if( a < b )
     {
-        size = sizeof(char *);
+        return(-1);
     }
 
-    if( size >= MEM_TABLE_SIZE )
-    {
-        return(core_mem_alloc(env, (unsigned)size));
-    }
+    return((a > b) ? 1 : 0);
+}
 
-    memPtr = (struct core_mem_ptr *)core_mem_get_memory_data(env)->memory_table[size];
+/***************************************************
+ * _find_slab: Returns the index of the slab in a
+ *   sorted array that contains the address, or -1.
+ ****************************************************/
+static long _find_slab(struct core_mem_slab **slabs, long count, void *address)
+{
+    long low = 0, high = count - 1, middle;
+    size_t target = (size_t)address, start;
 
-    if( memPtr == NULL )
+    while( low <= high )
     {
-        return(core_mem_alloc(env, (unsigned)size));
-    }
+        middle = (low + high) / 2;
+        start = (size_t)slabs[middle];
 
-    core_mem_get_memory_data(env)->memory_table[size] = memPtr->next;
+        if( target < start )
+        {
+            high = middle - 1;
+        }
+        else if( target >= start + MEM_SLAB_SIZE )
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            return(middle);
+        }
+    }
 
-    return((void *)memPtr);
+    return(-1);
 }
 
 /****************************************************
- * core_mem_alloc_large_no_init: Allocates memory and does not initialize it.
+ * core_mem_alloc_and_init: Allocates memory and sets all bytes to zero.
  *****************************************************/
-void *core_mem_alloc_large_no_init(void *env, size_t size)
+void *core_mem_alloc_and_init(void *env, size_t size)
 {
-    struct core_mem_ptr *memPtr;
+    char *tmpPtr;
+    size_t i;
 
-    if( size < (long)sizeof(char *))
+    if( size < sizeof(char *))
     {
         size = sizeof(char *);
     }
 
-    if( size >= MEM_TABLE_SIZE )
-    {
-        return(core_mem_alloc(env, size));
-    }
-
-    memPtr = (struct core_mem_ptr *)core_mem_get_memory_data(env)->memory_table[(int)size];
+    tmpPtr = (char *)core_mem_alloc(env, size);
 
-    if( memPtr == NULL )
+    for( i = 0 ; i < size ; i++ )
     {
-        return(core_mem_alloc(env, size));
+        tmpPtr[i] = '\0';
     }
 
-    core_mem_get_memory_data(env)->memory_table[(int)size] = memPtr->next;
+    return((void *)tmpPtr);
+}
 
-    return((void *)memPtr);
+/****************************************************
+ * core_mem_alloc_no_init: Allocates memory and does not initialize it.
+ *****************************************************/
+void *core_mem_alloc_no_init(void *env, size_t size)
+{
+    return(core_mem_alloc(env, size));
+}
+
+/****************************************************
+ * core_mem_alloc_large_no_init: Allocates memory and does not initialize it.
+ *****************************************************/
+void *core_mem_alloc_large_no_init(void *env, size_t size)
+{
+    return(core_mem_alloc(env, size));
 }
 
 /***************************************
@@ -374,28 +541,14 @@ void *core_mem_alloc_large_no_init(void *env, size_t size)
  ****************************************/
 int core_mem_release(void *env, void *str, size_t size)
 {
-    struct core_mem_ptr *memPtr;
-
     if( size == 0 )
     {
         error_system(env, "MEMORY", 1);
         exit_router(env, EXIT_FAILURE);
     }
 
-    if( size < sizeof(char *))
-    {
-        size = sizeof(char *);
-    }
-
-    if( size >= MEM_TABLE_SIZE )
-    {
-        return(core_mem_free(env, (void *)str, (unsigned)size));
-    }
-
-    memPtr = (struct core_mem_ptr *)str;
-    memPtr->next = core_mem_get_memory_data(env)->memory_table[size];
-    core_mem_get_memory_data(env)->memory_table[size] = memPtr;
-    return(1);
+    core_mem_free(env, (void *)str, size);
+    return((size >= MEM_TABLE_SIZE) ? 0 : 1);
 }
 
 /*******************************************
@@ -405,562 +558,283 @@ int core_mem_release(void *env, void *str, size_t size)
  ********************************************/
 int core_mem_release_sized(void *env, void *str, size_t size)
 {
-    struct core_mem_ptr *memPtr;
-
-    if( size == 0 )
-    {
-        error_system(env, "MEMORY", 1);
-        exit_router(env, EXIT_FAILURE);
-    }
-
-    if( size < (long)sizeof(char *))
-    {
-        size = sizeof(char *);
-    }
-
-    if( size >= MEM_TABLE_SIZE )
-    {
-        return(core_mem_free(env, (void *)str, (unsigned long)size));
-    }
-
-    memPtr = (struct core_mem_ptr *)str;
-    memPtr->next = core_mem_get_memory_data(env)->memory_table[(int)size];
-    core_mem_get_memory_data(env)->memory_table[(int)size] = memPtr;
-    return(1);
+    return(core_mem_release(env, str, size));
 }
 
 /**************************************************
- * core_mem_get_pool_sz: Returns number of bytes in free pool.
+ * core_mem_get_pool_sz: Returns number of bytes in free pool,
+ *   counting both returned objects and the space
+ *   left behind each class's bump pointer.
  ***************************************************/
 unsigned long core_mem_get_pool_sz(void *env)
 {
-    register int i;
-    struct core_mem_ptr *memPtr;
+    int i;
+    long available;
+    size_t objectSize;
     unsigned long cnt = 0;
 
-    for( i = sizeof(char *) ; i < MEM_TABLE_SIZE ; i++ )
+    for( i = 1 ; i < MEM_CLASS_COUNT ; i++ )
     {
-        memPtr = core_mem_get_memory_data(env)->memory_table[i];
-
-        while( memPtr != NULL )
-        {
-            cnt += (unsigned long)i;
-            memPtr = memPtr->next;
-        }
+        core_mem_get_class_stats(env, i, &objectSize, NULL, NULL, &available);
+        cnt += (unsigned long)available * objectSize;
     }
 
     return(cnt);
 }
 
-/*************************
- * core_mem_memcopy:
- **************************/
-void core_mem_memcopy(char *dst, char *src, unsigned long size)
+/**************************************************
+ * core_mem_get_class_count: Returns the number of
+ *   size classes. Class 0 is never used.
+ ***************************************************/
+int core_mem_get_class_count()
 {
-    unsigned long i;
-
-    for( i = 0L ; i < size ; i++ )
-    {
-        dst[i] = src[i];
-    }
+    return(MEM_CLASS_COUNT);
 }
 
-/*************************
- * BLOCK MEMORY FUNCTIONS
- **************************/
-
-#if BLOCK_MEMORY
-
 /**************************************************
- * InitializeBlockMemory: Initializes block memory
- *   management and allocates the first block.
+ * core_mem_get_class_stats: Returns the object size
+ *   of a size class along with its number of slabs,
+ *   objects in use and objects available without
+ *   getting another slab. Any of the result
+ *   pointers may be NULL.
  ***************************************************/
-static int InitializeBlockMemory(void *env, unsigned int requestSize)
+BOOLEAN core_mem_get_class_stats(void *env, int classIndex, size_t *objectSize, long *slabs, long *inUse, long *available)
 {
-    struct core_mem_chunk *chunkPtr;
-    unsigned int initialBlockSize, usableBlockSize;
-
-    /*===========================================
-     * The block memory routines depend upon the
-     * size of a character being 1 byte.
-     *===========================================*/
+    struct core_mem_class *memClass;
+    struct core_mem_ptr *memPtr;
+    long count = 0;
 
-    if( sizeof(char) != 1 )
+    if((classIndex <= 0) || (classIndex >= MEM_CLASS_COUNT))
     {
-        fprintf(stdout, "Size of character data is not 1\n");
-        fprintf(stdout, "Memory allocation functions may not work\n");
-        return(0);
+        return(FALSE);
     }
 
-    core_mem_get_memory_data(env)->ChunkInfoSize = sizeof(struct core_mem_chunk);
-    core_mem_get_memory_data(env)->ChunkInfoSize = (int)((((core_mem_get_memory_data(env)->ChunkInfoSize - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE);
-
-    core_mem_get_memory_data(env)->BlockInfoSize = sizeof(struct core_mem_block);
-    core_mem_get_memory_data(env)->BlockInfoSize = (int)((((core_mem_get_memory_data(env)->BlockInfoSize - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE);
-
-    initialBlockSize = (INITBLOCKSIZE > requestSize ? INITBLOCKSIZE : requestSize);
-    initialBlockSize += core_mem_get_memory_data(env)->ChunkInfoSize * 2 + core_mem_get_memory_data(env)->BlockInfoSize;
-    initialBlockSize = (((initialBlockSize - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE;
-
-    usableBlockSize = initialBlockSize - (2 * core_mem_get_memory_data(env)->ChunkInfoSize) - core_mem_get_memory_data(env)->BlockInfoSize;
+    memClass = &core_mem_get_memory_data(env)->classes[classIndex];
 
-    /* make sure we get a buffer big enough to be usable */
-    if((requestSize < INITBLOCKSIZE) &&
-       (usableBlockSize <= requestSize + core_mem_get_memory_data(env)->ChunkInfoSize))
+    if( objectSize != NULL )
     {
-        initialBlockSize = requestSize + core_mem_get_memory_data(env)->ChunkInfoSize * 2 + core_mem_get_memory_data(env)->BlockInfoSize;
-        initialBlockSize = (((initialBlockSize - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE;
-        usableBlockSize = initialBlockSize - (2 * core_mem_get_memory_data(env)->ChunkInfoSize) - core_mem_get_memory_data(env)->BlockInfoSize;
+        *objectSize = (size_t)classIndex * MEM_ALIGN_SIZE;
     }
 
-    core_mem_get_memory_data(env)->TopMemoryBlock = (struct core_mem_block *)malloc((STD_SIZE)initialBlockSize);
-
-    if( core_mem_get_memory_data(env)->TopMemoryBlock == NULL )
+    if( slabs != NULL )
     {
-        fprintf(stdout, "Unable to allocate initial memory pool\n");
-        return(0);
+        *slabs = memClass->slab_count;
     }
 
-    core_mem_get_memory_data(env)->TopMemoryBlock->next = NULL;
-    core_mem_get_memory_data(env)->TopMemoryBlock->previous = NULL;
-    core_mem_get_memory_data(env)->TopMemoryBlock->next_free = (struct core_mem_chunk *)(((char *)core_mem_get_memory_data(env)->TopMemoryBlock) + core_mem_get_memory_data(env)->BlockInfoSize);
-    core_mem_get_memory_data(env)->TopMemoryBlock->size = (long)usableBlockSize;
+    if( inUse != NULL )
+    {
+        *inUse = memClass->in_use;
+    }
 
-    chunkPtr = (struct core_mem_chunk *)(((char *)core_mem_get_memory_data(env)->TopMemoryBlock) + core_mem_get_memory_data(env)->BlockInfoSize + core_mem_get_memory_data(env)->ChunkInfoSize + usableBlockSize);
-    chunkPtr->next_free = NULL;
-    chunkPtr->last_free = NULL;
-    chunkPtr->previous = core_mem_get_memory_data(env)->TopMemoryBlock->next_free;
-    chunkPtr->size = 0;
+    if( available != NULL )
+    {
+        for( memPtr = memClass->free_list; memPtr != NULL; memPtr = memPtr->next )
+        {
+            count++;
+        }
 
-    core_mem_get_memory_data(env)->TopMemoryBlock->next_free->next_free = NULL;
-    core_mem_get_memory_data(env)->TopMemoryBlock->next_free->last_free = NULL;
-    core_mem_get_memory_data(env)->TopMemoryBlock->next_free->previous = NULL;
-    core_mem_get_memory_data(env)->TopMemoryBlock->next_free->size = (long)usableBlockSize;
+        count += (long)((size_t)(memClass->bump_end - memClass->bump) / ((size_t)classIndex * MEM_ALIGN_SIZE));
+        *available = count;
+    }
 
-    core_mem_get_memory_data(env)->BlockMemoryInitialized = TRUE;
-    return(1);
+    return(TRUE);
 }
 
-/**************************************************************************
- * AllocateBlock: Adds a new block of memory to the list of memory blocks.
- ***************************************************************************/
-static int AllocateBlock(void *env, struct core_mem_block *blockPtr, unsigned int requestSize)
+/**************************************************
+ * core_mem_region_begin: Opens a region. Until it
+ *   is stopped, core_mem_region_is_active is TRUE
+ *   and callers that support it allocate from the
+ *   region. Regions nest and must be ended in the
+ *   reverse order they were begun.
+ ***************************************************/
+void core_mem_region_begin(void *env, struct core_mem_region_mark *mark)
 {
-    unsigned int blockSize, usableBlockSize;
-    struct core_mem_block *newBlock;
-    struct core_mem_chunk *newTopChunk;
-
-    /*============================================================
-     * Determine the size of the block that needs to be allocated
-     * to satisfy the request. Normally, a default block size is
-     * used, but if the requested size is larger than the default
-     * size, then the requested size is used for the block size.
-     *============================================================*/
-
-    blockSize = (BLOCKSIZE > requestSize ? BLOCKSIZE : requestSize);
-    blockSize += core_mem_get_memory_data(env)->BlockInfoSize + core_mem_get_memory_data(env)->ChunkInfoSize * 2;
-    blockSize = (((blockSize - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE;
+    struct core_mem_memory *memData = core_mem_get_memory_data(env);
 
-    usableBlockSize = blockSize - core_mem_get_memory_data(env)->BlockInfoSize - (2 * core_mem_get_memory_data(env)->ChunkInfoSize);
+    mark->chunk = memData->region_current;
+    mark->bump = memData->region_bump;
+    mark->active = memData->region_active;
 
-    /*=========================
-     * Allocate the new block.
-     *=========================*/
-
-    newBlock = (struct core_mem_block *)malloc((STD_SIZE)blockSize);
-
-    if( newBlock == NULL )
-    {
-        return(0);
-    }
-
-    /*======================================
-     * Initialize the block data structure.
-     *======================================*/
-
-    newBlock->next = NULL;
-    newBlock->previous = blockPtr;
-    newBlock->next_free = (struct core_mem_chunk *)(((char *)newBlock) + core_mem_get_memory_data(env)->BlockInfoSize);
-    newBlock->size = (long)usableBlockSize;
-    blockPtr->next = newBlock;
+    memData->region_depth++;
+    memData->region_active = TRUE;
+}
 
-    newTopChunk = (struct core_mem_chunk *)(((char *)newBlock) + core_mem_get_memory_data(env)->BlockInfoSize + core_mem_get_memory_data(env)->ChunkInfoSize + usableBlockSize);
-    newTopChunk->next_free = NULL;
-    newTopChunk->last_free = NULL;
-    newTopChunk->size = 0;
-    newTopChunk->previous = newBlock->next_free;
+/**************************************************
+ * core_mem_region_stop: Stops allocating from the
+ *   region without releasing what it holds. Used
+ *   once parsing is done and evaluation begins.
+ ***************************************************/
+void core_mem_region_stop(void *env, struct core_mem_region_mark *mark)
+{
+    core_mem_get_memory_data(env)->region_active = mark->active;
+}
 
-    newBlock->next_free->next_free = NULL;
-    newBlock->next_free->last_free = NULL;
-    newBlock->next_free->previous = NULL;
-    newBlock->next_free->size = (long)usableBlockSize;
+/**************************************************
+ * core_mem_region_end: Releases everything that
+ *   was allocated since the region was begun by
+ *   moving the bump pointer back to the mark.
+ ***************************************************/
+void core_mem_region_end(void *env, struct core_mem_region_mark *mark)
+{
+    struct core_mem_memory *memData = core_mem_get_memory_data(env);
 
-    return(1);
+    memData->region_current = mark->chunk;
+    memData->region_bump = mark->bump;
+    memData->region_active = mark->active;
+    memData->region_depth--;
 }
 
-/******************************************************
- * RequestChunk: Allocates memory by returning a chunk
- *   of memory from a larger block of memory.
- *******************************************************/
-void *RequestChunk(void *env, size_t requestSize)
+/**************************************************
+ * core_mem_region_alloc: Returns size bytes from
+ *   the innermost open region.
+ ***************************************************/
+void *core_mem_region_alloc(void *env, size_t size)
 {
-    struct core_mem_chunk *chunkPtr;
-    struct core_mem_block *blockPtr;
+    struct core_mem_memory *memData = core_mem_get_memory_data(env);
+    char *memPtr;
 
-    /*==================================================
-     * Allocate initial memory pool block if it has not
-     * already been allocated.
-     *==================================================*/
+    size = ((size + (MEM_ALIGN_SIZE - 1)) / MEM_ALIGN_SIZE) * MEM_ALIGN_SIZE;
 
-    if( core_mem_get_memory_data(env)->BlockMemoryInitialized == FALSE )
+    if((memData->region_current == NULL) ||
+       ((size_t)(memData->region_current->end - memData->region_bump) < size))
     {
-        if( InitializeBlockMemory(env, requestSize) == 0 )
+        if( _next_region_chunk(env, size) == NULL )
         {
             return(NULL);
         }
     }
 
-    /*====================================================
-     * Make sure that the amount of memory requested will
-     * fall on a boundary of strictest alignment
-     *====================================================*/
-
-    requestSize = (((requestSize - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE;
+    memPtr = memData->region_bump;
+    memData->region_bump += size;
+    memData->allocations++;
+    memData->allocated += (long)size;
 
-    /*=====================================================
-     * Search through the list of free memory for a block
-     * of the appropriate size.  If a block is found, then
-     * allocate and return a pointer to it.
-     *=====================================================*/
+    return((void *)memPtr);
+}
 
-    blockPtr = core_mem_get_memory_data(env)->TopMemoryBlock;
+/**************************************************
+ * _next_region_chunk: Moves the region on to the
+ *   next chunk, reusing a spare chunk left by an
+ *   earlier region when it is large enough.
+ ***************************************************/
+static void *_next_region_chunk(void *env, size_t size)
+{
+    struct core_mem_memory *memData = core_mem_get_memory_data(env);
+    struct core_mem_region_chunk *chunk, **link;
+    size_t chunkSize;
 
-    while( blockPtr != NULL )
+    if( memData->region_current == NULL )
     {
-        chunkPtr = blockPtr->next_free;
-
-        while( chunkPtr != NULL )
-        {
-            if((chunkPtr->size == requestSize) ||
-               (chunkPtr->size > (requestSize + core_mem_get_memory_data(env)->ChunkInfoSize)))
-            {
-                AllocateChunk(env, blockPtr, chunkPtr, requestSize);
-
-                return((void *)(((char *)chunkPtr) + core_mem_get_memory_data(env)->ChunkInfoSize));
-            }
-
-            chunkPtr = chunkPtr->next_free;
-        }
-
-        if( blockPtr->next == NULL )
-        {
-            if( AllocateBlock(env, blockPtr, requestSize) == 0 )  /* get another block */
-            {
-                return(NULL);
-            }
-        }
-
-        blockPtr = blockPtr->next;
+        link = &memData->region_chunks;
+    }
+    else
+    {
+        link = &memData->region_current->next;
     }
 
-    error_system(env, "MEMORY", 2);
-    exit_router(env, EXIT_FAILURE);
-    return(NULL); /* Unreachable, but prevents warning. */
-}
-
-/*******************************************
- * AllocateChunk: Allocates a chunk from an
- *   existing chunk in a block of memory.
- ********************************************/
-static void AllocateChunk(void *env, struct core_mem_block *parentBlock, struct core_mem_chunk *chunkPtr, size_t requestSize)
-{
-    struct core_mem_chunk *splitChunk, *nextChunk;
-
-    /*=============================================================
-     * If the size of the memory chunk is an exact match for the
-     * requested amount of memory, then the chunk can be allocated
-     * without splitting it.
-     *=============================================================*/
+    chunk = *link;
 
-    if( requestSize == chunkPtr->size )
+    if((chunk == NULL) || ((size_t)(chunk->end - (((char *)chunk) + MEM_REGION_HEADER_SZ)) < size))
     {
-        chunkPtr->size = -(long int)requestSize;
+        chunkSize = MEM_REGION_HEADER_SZ + size;
 
-        if( chunkPtr->last_free == NULL )
-        {
-            if( chunkPtr->next_free != NULL )
-            {
-                parentBlock->next_free = chunkPtr->next_free;
-            }
-            else
-            {
-                parentBlock->next_free = NULL;
-            }
-        }
-        else
+        if( chunkSize < MEM_REGION_SIZE )
         {
-            chunkPtr->last_free->next_free = chunkPtr->next_free;
+            chunkSize = MEM_REGION_SIZE;
         }
 
-        if( chunkPtr->next_free != NULL )
+        chunk = (struct core_mem_region_chunk *)_system_alloc(env, chunkSize);
+
+        if( chunk == NULL )
         {
-            chunkPtr->next_free->last_free = chunkPtr->last_free;
+            return(NULL);
         }
 
-        chunkPtr->last_free = NULL;
-        chunkPtr->next_free = NULL;
-        return;
-    }
-
-    /*===========================================================
-     * If the size of the memory chunk is larger than the memory
-     * request, then split the chunk into two pieces.
-     *===========================================================*/
-
-    nextChunk = (struct core_mem_chunk *)
-                (((char *)chunkPtr) + core_mem_get_memory_data(env)->ChunkInfoSize + chunkPtr->size);
-
-    splitChunk = (struct core_mem_chunk *)
-                 (((char *)chunkPtr) + (core_mem_get_memory_data(env)->ChunkInfoSize + requestSize));
-
-    splitChunk->size = (long)(chunkPtr->size - (requestSize + core_mem_get_memory_data(env)->ChunkInfoSize));
-    splitChunk->previous = chunkPtr;
-
-    splitChunk->next_free = chunkPtr->next_free;
-    splitChunk->last_free = chunkPtr->last_free;
-
-    nextChunk->previous = splitChunk;
-
-    if( splitChunk->last_free == NULL )
-    {
-        parentBlock->next_free = splitChunk;
-    }
-    else
-    {
-        splitChunk->last_free->next_free = splitChunk;
-    }
-
-    if( splitChunk->next_free != NULL )
-    {
-        splitChunk->next_free->last_free = splitChunk;
+        chunk->end = ((char *)chunk) + chunkSize;
+        chunk->next = *link;
+        *link = chunk;
     }
 
-    chunkPtr->size = -(long int)requestSize;
-    chunkPtr->last_free = NULL;
-    chunkPtr->next_free = NULL;
+    memData->region_current = chunk;
+    memData->region_bump = ((char *)chunk) + MEM_REGION_HEADER_SZ;
 
-    return;
+    return((void *)chunk);
 }
 
-/**********************************************************
- * ReturnChunk: Frees memory allocated using RequestChunk.
- ***********************************************************/
-int ReturnChunk(void *env, void *memPtr, size_t size)
+/**************************************************
+ * core_mem_region_contains: Returns TRUE if the
+ *   address belongs to an open region.
+ ***************************************************/
+BOOLEAN core_mem_region_contains(void *env, void *address)
 {
-    struct core_mem_chunk *chunkPtr, *lastChunk, *nextChunk, *topChunk;
-    struct core_mem_block *blockPtr;
-
-    /*=====================================================
-     * Determine if the expected size of the chunk matches
-     * the size stored in the chunk's information record.
-     *=====================================================*/
-
-    size = (((size - 1) / STRICT_ALIGN_SIZE) + 1) * STRICT_ALIGN_SIZE;
-
-    chunkPtr = (struct core_mem_chunk *)(((char *)memPtr) - core_mem_get_memory_data(env)->ChunkInfoSize);
-
-    if( chunkPtr == NULL )
-    {
-        return(FALSE);
-    }
+    struct core_mem_memory *memData = core_mem_get_memory_data(env);
+    struct core_mem_region_chunk *chunk;
+    size_t addr = (size_t)address;
 
-    if( chunkPtr->size >= 0 )
+    if((memData->region_depth == 0) || (memData->region_current == NULL))
     {
         return(FALSE);
     }
 
-    if( chunkPtr->size != -(long int)size )
+    for( chunk = memData->region_chunks; chunk != NULL; chunk = chunk->next )
     {
-        return(FALSE);
-    }
-
-    chunkPtr->size = -chunkPtr->size;
-
-    /*=============================================
-     * Determine in which block the chunk resides.
-     *=============================================*/
-
-    topChunk = chunkPtr;
-
-    while( topChunk->previous != NULL )
-    {
-        topChunk = topChunk->previous;
-    }
-
-    blockPtr = (struct core_mem_block *)(((char *)topChunk) - core_mem_get_memory_data(env)->BlockInfoSize);
-
-    /*===========================================
-     * Determine the chunks physically preceding
-     * and following the returned chunk.
-     *===========================================*/
-
-    lastChunk = chunkPtr->previous;
-    nextChunk = (struct core_mem_chunk *)(((char *)memPtr) + size);
-
-    /*=========================================================
-     * Add the chunk to the list of free chunks for the block.
-     *=========================================================*/
-
-    if( blockPtr->next_free != NULL )
-    {
-        blockPtr->next_free->last_free = chunkPtr;
-    }
-
-    chunkPtr->next_free = blockPtr->next_free;
-    chunkPtr->last_free = NULL;
-
-    blockPtr->next_free = chunkPtr;
-
-    /*=====================================================
-     * Combine this chunk with previous chunk if possible.
-     *=====================================================*/
-
-    if( lastChunk != NULL )
-    {
-        if( lastChunk->size > 0 )
+        if((addr >= (size_t)chunk) && (addr < (size_t)chunk->end))
         {
-            lastChunk->size += (core_mem_get_memory_data(env)->ChunkInfoSize + chunkPtr->size);
-
-            if( nextChunk != NULL )
-            {
-                nextChunk->previous = lastChunk;
-            }
-            else
-            {
-                return(FALSE);
-            }
-
-            if( lastChunk->last_free != NULL )
-            {
-                lastChunk->last_free->next_free = lastChunk->next_free;
-            }
-
-            if( lastChunk->next_free != NULL )
-            {
-                lastChunk->next_free->last_free = lastChunk->last_free;
-            }
-
-            lastChunk->next_free = chunkPtr->next_free;
-
-            if( chunkPtr->next_free != NULL )
-            {
-                chunkPtr->next_free->last_free = lastChunk;
-            }
-
-            lastChunk->last_free = NULL;
+            return(TRUE);
+        }
 
-            blockPtr->next_free = lastChunk;
-            chunkPtr->last_free = NULL;
-            chunkPtr->next_free = NULL;
-            chunkPtr = lastChunk;
+        if( chunk == memData->region_current )
+        {
+            break;
         }
     }
 
-    /*=====================================================
-     * Combine this chunk with the next chunk if possible.
-     *=====================================================*/
+    return(FALSE);
+}
 
-    if( nextChunk == NULL )
-    {
-        return(FALSE);
-    }
+/**************************************************
+ * _release_region_chunks: Frees the spare region
+ *   chunks beyond the one in use. Returns the
+ *   number of bytes released.
+ ***************************************************/
+static long _release_region_chunks(void *env)
+{
+    struct core_mem_memory *memData = core_mem_get_memory_data(env);
+    struct core_mem_region_chunk *chunk, *next, **link;
+    long amount = 0;
+    size_t chunkSize;
 
-    if( chunkPtr == NULL )
+    if( memData->region_current == NULL )
     {
-        return(FALSE);
+        link = &memData->region_chunks;
     }
-
-    if( nextChunk->size > 0 )
+    else
     {
-        chunkPtr->size += (core_mem_get_memory_data(env)->ChunkInfoSize + nextChunk->size);
-
-        topChunk = (struct core_mem_chunk *)(((char *)nextChunk) + nextChunk->size + core_mem_get_memory_data(env)->ChunkInfoSize);
-
-        if( topChunk != NULL )
-        {
-            topChunk->previous = chunkPtr;
-        }
-        else
-        {
-            return(FALSE);
-        }
-
-        if( nextChunk->last_free != NULL )
-        {
-            nextChunk->last_free->next_free = nextChunk->next_free;
-        }
-
-        if( nextChunk->next_free != NULL )
-        {
-            nextChunk->next_free->last_free = nextChunk->last_free;
-        }
+        link = &memData->region_current->next;
     }
 
-    /*===========================================
-     * Free the buffer if we can, but don't free
-     * the first buffer if it's the only one.
-     *===========================================*/
-
-    if((chunkPtr->previous == NULL) &&
-       (chunkPtr->size == blockPtr->size))
+    for( chunk = *link; chunk != NULL; chunk = next )
     {
-        if( blockPtr->previous != NULL )
-        {
-            blockPtr->previous->next = blockPtr->next;
-
-            if( blockPtr->next != NULL )
-            {
-                blockPtr->next->previous = blockPtr->previous;
-            }
-
-            free((char *)blockPtr);
-        }
-        else
-        {
-            if( blockPtr->next != NULL )
-            {
-                blockPtr->next->previous = NULL;
-                core_mem_get_memory_data(env)->TopMemoryBlock = blockPtr->next;
-                free((char *)blockPtr);
-            }
-        }
+        next = chunk->next;
+        chunkSize = (size_t)(chunk->end - (char *)chunk);
+        _system_free(env, (void *)chunk, chunkSize);
+        amount += (long)chunkSize;
     }
 
-    return(TRUE);
+    *link = NULL;
+
+    return(amount);
 }
 
-/**********************************************
- * ReturnAllBlocks: Frees all allocated blocks
- *   back to the operating system.
- ***********************************************/
-void ReturnAllBlocks(void *env)
+/*************************
+ * core_mem_memcopy:
+ **************************/
+void core_mem_memcopy(char *dst, char *src, unsigned long size)
 {
-    struct core_mem_block *theBlock, *next;
-
-    /*======================================
-     * Free up int based memory allocation.
-     *======================================*/
-
-    theBlock = core_mem_get_memory_data(env)->TopMemoryBlock;
+    unsigned long i;
 
-    while( theBlock != NULL )
+    for( i = 0L ; i < size ; i++ )
     {
-        next = theBlock->next;
-        free((char *)theBlock);
-        theBlock = next;
+        dst[i] = src[i];
     }
-
-    core_mem_get_memory_data(env)->TopMemoryBlock = NULL;
 }
-
-#endif
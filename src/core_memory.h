@@ -6,11 +6,27 @@
 
 #define __CORE_MEMORY_H__
 
-struct core_mem_chunk;
-struct core_mem_block;
 struct core_mem_ptr;
-
-#define MEM_TABLE_SIZE 500
+struct core_mem_slab;
+struct core_mem_class;
+struct core_mem_region_chunk;
+struct core_mem_region_mark;
+
+/*==================================================
+ * Requests smaller than MEM_TABLE_SIZE are served
+ * from size classes MEM_ALIGN_SIZE bytes apart.
+ * Each class carves its objects out of slabs of
+ * MEM_SLAB_SIZE bytes, first from a free list of
+ * returned objects, then by bumping a pointer
+ * through the newest slab. Larger requests go to
+ * malloc directly.
+ *==================================================*/
+#define MEM_TABLE_SIZE  500
+#define MEM_ALIGN_SIZE  8
+#define MEM_SLAB_SIZE   4096
+#define MEM_CLASS_COUNT (((MEM_TABLE_SIZE - 1) + (MEM_ALIGN_SIZE - 1)) / MEM_ALIGN_SIZE + 1)
+
+#define core_mem_class_of(size) (((size) + (MEM_ALIGN_SIZE - 1)) / MEM_ALIGN_SIZE)
 
 #ifdef LOCALE
 #undef LOCALE
@@ -22,101 +38,116 @@ struct core_mem_ptr;
 #define LOCALE extern
 #endif
 
-struct core_mem_chunk
+struct core_mem_ptr
 {
-    struct core_mem_chunk *previous;
-    struct core_mem_chunk *next_free;
-    struct core_mem_chunk *last_free;
-    long int               size;
+    struct core_mem_ptr *next;
 };
 
-struct core_mem_block
+struct core_mem_slab
 {
-    struct core_mem_block *next;
-    struct core_mem_block *previous;
-    struct core_mem_chunk *next_free;
-    long int               size;
+    struct core_mem_slab *next;
 };
 
-struct core_mem_ptr
+struct core_mem_class
 {
-    struct core_mem_ptr *next;
+    struct core_mem_ptr  *free_list;
+    char                 *bump;
+    char                 *bump_end;
+    struct core_mem_slab *slabs;
+    long                  slab_count;
+    long                  in_use;
 };
 
+/*==================================================
+ * Regions hand out memory by bumping a pointer
+ * through chunks of at least MEM_REGION_SIZE bytes.
+ * Objects are never freed one at a time; ending a
+ * region drops everything allocated since it began
+ * and keeps the chunks for the next region.
+ *==================================================*/
+#define MEM_REGION_SIZE 8192
+
+struct core_mem_region_chunk
+{
+    struct core_mem_region_chunk *next;
+    char                         *end;
+};
+
+struct core_mem_region_mark
+{
+    struct core_mem_region_chunk *chunk;
+    char                         *bump;
+    BOOLEAN                       active;
+};
+
+#define core_mem_class(env, size) (&core_mem_get_memory_data(env)->classes[core_mem_class_of(size)])
+
 #define core_mem_get_struct(env, type) \
-    ((core_mem_get_memory_data(env)->memory_table[sizeof(struct type)] == NULL) ? \
-     ((struct type *)core_mem_alloc(env, sizeof(struct type))) : \
-     ((core_mem_get_memory_data(env)->temp_memory = core_mem_get_memory_data(env)->memory_table[sizeof(struct type)]), \
-                                                    core_mem_get_memory_data(env)->memory_table[sizeof(struct type)] = core_mem_get_memory_data(env)->temp_memory->next, \
-                                                    ((struct type *)core_mem_get_memory_data(env)->temp_memory)))
+    ((core_mem_class(env, sizeof(struct type))->free_list == NULL) ? \
+     ((struct type *)core_mem_alloc_small(env, sizeof(struct type))) : \
+     ((core_mem_get_memory_data(env)->temp_memory = core_mem_class(env, sizeof(struct type))->free_list), \
+      core_mem_class(env, sizeof(struct type))->free_list = core_mem_get_memory_data(env)->temp_memory->next, \
+      core_mem_class(env, sizeof(struct type))->in_use++, \
+      core_mem_get_memory_data(env)->allocations++, \
+      core_mem_get_memory_data(env)->allocated += (long)sizeof(struct type), \
+      ((struct type *)core_mem_get_memory_data(env)->temp_memory)))
 
 #define core_mem_return_struct(env, type, struct_ptr) \
-    (core_mem_get_memory_data(env)->temp_memory = (struct core_mem_ptr *)struct_ptr, \
-     core_mem_get_memory_data(env)->temp_memory->next = core_mem_get_memory_data(env)->memory_table[sizeof(struct type)], \
-     core_mem_get_memory_data(env)->memory_table[sizeof(struct type)] = core_mem_get_memory_data(env)->temp_memory)
+    core_mem_return_fixed_struct(env, sizeof(struct type), struct_ptr)
 
 #define core_mem_return_fixed_struct(env, size, struct_ptr) \
-    (core_mem_get_memory_data(env)->temp_memory = (struct core_mem_ptr *)struct_ptr, \
-     core_mem_get_memory_data(env)->temp_memory->next = core_mem_get_memory_data(env)->memory_table[size], \
-     core_mem_get_memory_data(env)->memory_table[size] = core_mem_get_memory_data(env)->temp_memory)
+    (core_mem_get_memory_data(env)->temp_memory = (struct core_mem_ptr *)(struct_ptr), \
+     core_mem_get_memory_data(env)->temp_memory->next = core_mem_class(env, size)->free_list, \
+     core_mem_class(env, size)->in_use--, \
+     core_mem_class(env, size)->free_list = core_mem_get_memory_data(env)->temp_memory)
 
 #define core_mem_get_dynamic_struct(env, type, vsize) \
-    ((((sizeof(struct type) + vsize) <  MEM_TABLE_SIZE) ? \
-      (core_mem_get_memory_data(env)->memory_table[sizeof(struct type) + vsize] == NULL) : 1) ? \
-     ((struct type *)core_mem_alloc(env, (sizeof(struct type) + vsize))) : \
-     ((core_mem_get_memory_data(env)->temp_memory = core_mem_get_memory_data(env)->memory_table[sizeof(struct type) + vsize]), \
-                                                    core_mem_get_memory_data(env)->memory_table[sizeof(struct type) + vsize] = core_mem_get_memory_data(env)->temp_memory->next, \
-                                                    ((struct type *)core_mem_get_memory_data(env)->temp_memory)))
+    ((struct type *)core_mem_alloc(env, sizeof(struct type) + (vsize)))
 
 #define core_mem_release_dynamic_struct(env, type, vsize, struct_ptr) \
-    (core_mem_get_memory_data(env)->temp_sz = sizeof(struct type) + vsize, \
-     ((core_mem_get_memory_data(env)->temp_sz < MEM_TABLE_SIZE) ? \
-      (core_mem_get_memory_data(env)->temp_memory = (struct core_mem_ptr *)struct_ptr, \
-       core_mem_get_memory_data(env)->temp_memory->next = core_mem_get_memory_data(env)->memory_table[core_mem_get_memory_data(env)->temp_sz], \
-       core_mem_get_memory_data(env)->memory_table[core_mem_get_memory_data(env)->temp_sz] =  core_mem_get_memory_data(env)->temp_memory) : \
-                                                                                             (core_mem_free(env, (void *)struct_ptr, core_mem_get_memory_data(env)->temp_sz), (struct core_mem_ptr *)struct_ptr)))
+    core_mem_free(env, (void *)(struct_ptr), sizeof(struct type) + (vsize))
 
 #define core_mem_get_memory(env, size) \
-    (((size <  MEM_TABLE_SIZE) ? \
-      (core_mem_get_memory_data(env)->memory_table[size] == NULL) : 1) ? \
-     ((struct type *)core_mem_alloc(env, (size_t)(size))) : \
-     ((core_mem_get_memory_data(env)->temp_memory = core_mem_get_memory_data(env)->memory_table[size]), \
-                                                    core_mem_get_memory_data(env)->memory_table[size] = core_mem_get_memory_data(env)->temp_memory->next, \
-                                                    ((struct type *)core_mem_get_memory_data(env)->temp_memory)))
+    core_mem_alloc(env, (size_t)(size))
 
 #define core_mem_return_memory(env, size, ptr) \
-    (core_mem_get_memory_data(env)->temp_sz = size, \
-     ((core_mem_get_memory_data(env)->temp_sz < MEM_TABLE_SIZE) ? \
-      (core_mem_get_memory_data(env)->temp_memory = (struct core_mem_ptr *)ptr, \
-       core_mem_get_memory_data(env)->temp_memory->next = core_mem_get_memory_data(env)->memory_table[core_mem_get_memory_data(env)->temp_sz], \
-       core_mem_get_memory_data(env)->memory_table[core_mem_get_memory_data(env)->temp_sz] =  core_mem_get_memory_data(env)->temp_memory) : \
-                                                                                             (core_mem_free(env, (void *)ptr, core_mem_get_memory_data(env)->temp_sz), (struct core_mem_ptr *)ptr)))
+    core_mem_free(env, (void *)(ptr), (size_t)(size))
 
 #define core_mem_copy_memory(type, cnt, dst, src) memcpy((void *)(dst), (void *)(src), sizeof(type) * (size_t)(cnt))
 
 #define MEMORY_DATA_INDEX 59
 
+/*==================================================
+ * amount and calls are the memory held from the
+ * system, slabs and large blocks, and go down when
+ * it is given back. allocations and allocated count
+ * every request and the bytes asked for, and only
+ * ever go up.
+ *==================================================*/
 struct core_mem_memory
 {
     long int amount;
     long int calls;
+    long int allocations;
+    long int allocated;
     BOOLEAN  conservation;
     int      (*fn_out_of_memory)(void *, size_t);
-#if BLOCK_MEMORY
-    struct core_mem_block *TopMemoryBlock;
-    int                    BlockInfoSize;
-    int                    ChunkInfoSize;
-    int                    BlockMemoryInitialized;
-#endif
     struct core_mem_ptr * temp_memory;
-    struct core_mem_ptr **memory_table;
-    size_t                temp_sz;
+    struct core_mem_class classes[MEM_CLASS_COUNT];
+    struct core_mem_region_chunk *region_chunks;
+    struct core_mem_region_chunk *region_current;
+    char *   region_bump;
+    int      region_depth;
+    BOOLEAN  region_active;
 };
 
 #define core_mem_get_memory_data(env) ((struct core_mem_memory *)core_get_environment_data(env, MEMORY_DATA_INDEX))
 
+#define core_mem_region_is_active(env) (core_mem_get_memory_data(env)->region_active)
+
 LOCALE void core_mem_init_memory(void *);
 LOCALE void *core_mem_alloc(void *, size_t);
+LOCALE void *core_mem_alloc_small(void *, size_t);
 LOCALE int core_mem_fn_out_of_memory(void *, size_t);
 LOCALE int core_mem_free(void *, void *, size_t);
 LOCALE void *core_mem_realloc(void *, void *, size_t, size_t);
@@ -127,6 +158,13 @@ LOCALE void *core_mem_alloc_large_no_init(void *, size_t);
 LOCALE int core_mem_release(void *, void *, size_t);
 LOCALE int core_mem_release_sized(void *, void *, size_t);
 LOCALE unsigned long core_mem_get_pool_sz(void *);
+LOCALE int           core_mem_get_class_count(void);
+LOCALE BOOLEAN       core_mem_get_class_stats(void *, int, size_t *, long *, long *, long *);
+LOCALE void          core_mem_region_begin(void *, struct core_mem_region_mark *);
+LOCALE void          core_mem_region_stop(void *, struct core_mem_region_mark *);
+LOCALE void          core_mem_region_end(void *, struct core_mem_region_mark *);
+LOCALE void *        core_mem_region_alloc(void *, size_t);
+LOCALE BOOLEAN       core_mem_region_contains(void *, void *);
 LOCALE void          core_mem_memcopy(char *, char *, unsigned long);
 
 #endif
@@ -30,6 +30,19 @@ static void                   * _scan_atom(void *, char *, int, unsigned short *
 static void                   * _scan_string(void *, char *);
 static void                     _scan_number(void *, char *, struct token *);
 static void                     _delete_scanner_data(void *);
+static void                     _skip_buffered_space(void *, struct router_buffer *, BOOLEAN);
+static int                      _scan_buffered_atom(void *, struct router_buffer *);
+static int                      _scan_buffered_string(void *, struct router_buffer *, BOOLEAN, char **, size_t *, size_t *);
+
+/*==================================================
+ * Characters that end a symbol.
+ *==================================================*/
+#define _is_atom_char(ch) \
+    (((ch) != '"') && \
+     ((ch) != '(') && ((ch) != ')') && \
+     ((ch) != '&') && ((ch) != '|') && ((ch) != '~') && \
+     ((ch) != ' ') && ((ch) != ';') && \
+     isprint(ch))
 
 /***********************************************
  * core_init_scanner_data: Allocates environment
@@ -64,6 +77,7 @@ void core_get_token(void *env, char *logicalName, struct token *theToken)
 {
     int inchar;
     unsigned short type;
+    struct router_buffer *buffer;
 
     /*=======================================
      * Set Unknown default values for token.
@@ -77,9 +91,17 @@ void core_get_token(void *env, char *logicalName, struct token *theToken)
 
     /*==============================================
      * Remove all white space before processing the
-     * core_get_token() request.
+     * core_get_token() request. Buffered input is
+     * skipped over directly.
      *==============================================*/
 
+    buffer = get_router_buffer(env, logicalName);
+
+    if( buffer != NULL )
+    {
+        _skip_buffered_space(env, buffer, (get_router_data(env)->line_count_router == logicalName) ? TRUE : FALSE);
+    }
+
     inchar = get_ch_router(env, logicalName);
 
     while((inchar == ' ') || (inchar == '\n') || (inchar == '\f') ||
@@ -287,6 +309,7 @@ void core_get_token(void *env, char *logicalName, struct token *theToken)
 static void *_scan_atom(void *env, char *logicalName, int count, unsigned short *type)
 {
     int inchar;
+    struct router_buffer *buffer;
 
 #if OBJECT_SYSTEM
     void *symbol;
@@ -297,27 +320,32 @@ static void *_scan_atom(void *env, char *logicalName, int count, unsigned short
      * symbol until a delimiter is found.
      *=====================================*/
 
-    inchar = get_ch_router(env, logicalName);
+    buffer = get_router_buffer(env, logicalName);
 
-    while( (inchar != '"') &&
-           (inchar != '(') && (inchar != ')') &&
-           (inchar != '&') && (inchar != '|') && (inchar != '~') &&
-           (inchar != ' ') && (inchar != ';') &&
-           isprint(inchar) )
+    if( buffer != NULL )
     {
-        core_get_scanner_data(env)->global_str = core_gc_expand_string(env, inchar, core_get_scanner_data(env)->global_str, &core_get_scanner_data(env)->global_position, &core_get_scanner_data(env)->global_max, core_get_scanner_data(env)->global_max + 80);
-
-        count++;
-        inchar = get_ch_router(env, logicalName);
+        count += _scan_buffered_atom(env, buffer);
     }
+    else
+    {
+        inchar = get_ch_router(env, logicalName);
 
-    /*===================================================
-     * Return the last character scanned (the delimiter)
-     * to the input stream so it will be scanned as part
-     * of the next token.
-     *===================================================*/
+        while( _is_atom_char(inchar))
+        {
+            core_get_scanner_data(env)->global_str = core_gc_expand_string(env, inchar, core_get_scanner_data(env)->global_str, &core_get_scanner_data(env)->global_position, &core_get_scanner_data(env)->global_max, core_get_scanner_data(env)->global_max + 80);
 
-    unget_ch_router(env, inchar, logicalName);
+            count++;
+            inchar = get_ch_router(env, logicalName);
+        }
+
+        /*===================================================
+         * Return the last character scanned (the delimiter)
+         * to the input stream so it will be scanned as part
+         * of the next token.
+         *===================================================*/
+
+        unget_ch_router(env, inchar, logicalName);
+    }
 
     /*====================================================
      * Add the symbol to the symbol table and return the
@@ -369,23 +397,34 @@ static void *_scan_string(void *env, char *logicalName)
     size_t max = 0;
     char *theString = NULL;
     void *thePtr;
+    struct router_buffer *buffer;
 
     /*============================================
      * Scan characters and add them to the string
      * until the " delimiter is found.
      *============================================*/
 
-    inchar = get_ch_router(env, logicalName);
+    buffer = get_router_buffer(env, logicalName);
 
-    while((inchar != '"') && (inchar != EOF))
+    if( buffer != NULL )
     {
-        if( inchar == '\\' )
+        inchar = _scan_buffered_string(env, buffer, (get_router_data(env)->line_count_router == logicalName) ? TRUE : FALSE,
+                                       &theString, &pos, &max);
+    }
+    else
+    {
+        inchar = get_ch_router(env, logicalName);
+
+        while((inchar != '"') && (inchar != EOF))
         {
+            if( inchar == '\\' )
+            {
+                inchar = get_ch_router(env, logicalName);
+            }
+
+            theString = core_gc_expand_string(env, inchar, theString, &pos, &max, max + 80);
             inchar = get_ch_router(env, logicalName);
         }
-
-        theString = core_gc_expand_string(env, inchar, theString, &pos, &max, max + 80);
-        inchar = get_ch_router(env, logicalName);
     }
 
     if((inchar == EOF) && (core_get_scanner_data(env)->ignoring_completion_error == FALSE))
@@ -412,6 +451,148 @@ static void *_scan_string(void *env, char *logicalName)
     return(thePtr);
 }
 
+/****************************************************
+ * _skip_buffered_space: Moves a buffer past white
+ *   space and comments, stopping in front of the
+ *   first character of the next token.
+ *****************************************************/
+static void _skip_buffered_space(void *env, struct router_buffer *buffer, BOOLEAN countLines)
+{
+    char *next, *end;
+    BOOLEAN inComment = FALSE;
+
+    do
+    {
+        next = buffer->data + buffer->position;
+        end = buffer->data + buffer->size;
+
+        while( next < end )
+        {
+            if((*next == '\n') || (*next == '\r'))
+            {
+                inComment = FALSE;
+
+                if( countLines )
+                {
+                    core_inc_line_count(env);
+                }
+            }
+            else if( inComment || (*next == ';'))
+            {
+                inComment = TRUE;
+            }
+            else if((*next != ' ') && (*next != '\t') && (*next != '\f'))
+            {
+                buffer->position = (size_t)(next - buffer->data);
+                return;
+            }
+
+            next++;
+        }
+
+        buffer->position = (size_t)(next - buffer->data);
+    }
+    while( router_buffer_fill(env, buffer));
+}
+
+/****************************************************
+ * _scan_buffered_atom: Adds the symbol characters at
+ *   the front of a buffer to the scanner string a
+ *   run at a time. Returns the number added.
+ *****************************************************/
+static int _scan_buffered_atom(void *env, struct router_buffer *buffer)
+{
+    struct core_scanner_data *scanData = core_get_scanner_data(env);
+    char *start, *next, *end;
+    int count = 0;
+
+    do
+    {
+        start = next = buffer->data + buffer->position;
+        end = buffer->data + buffer->size;
+
+        while((next < end) && _is_atom_char((unsigned char)*next))
+        {
+            next++;
+        }
+
+        if( next > start )
+        {
+            scanData->global_str = core_gc_append_subset_to_string(env, start, scanData->global_str, (size_t)(next - start),
+                                                                   &scanData->global_position, &scanData->global_max);
+            count += (int)(next - start);
+        }
+
+        buffer->position = (size_t)(next - buffer->data);
+    }
+    while((next == end) && router_buffer_fill(env, buffer));
+
+    return(count);
+}
+
+/****************************************************
+ * _scan_buffered_string: Scans the body of a string
+ *   from a buffer, copying the runs between escapes.
+ *   Returns the closing " or EOF.
+ *****************************************************/
+static int _scan_buffered_string(void *env, struct router_buffer *buffer, BOOLEAN countLines, char **theString, size_t *pos, size_t *max)
+{
+    char *start, *next, *end;
+    int inchar;
+
+    for(;; )
+    {
+        start = next = buffer->data + buffer->position;
+        end = buffer->data + buffer->size;
+
+        while((next < end) && (*next != '"') && (*next != '\\') && (*next != '\0') && (*next != '\b'))
+        {
+            if( countLines && ((*next == '\n') || (*next == '\r')))
+            {
+                core_inc_line_count(env);
+            }
+
+            next++;
+        }
+
+        if( next > start )
+        {
+            *theString = core_gc_append_subset_to_string(env, start, *theString, (size_t)(next - start), pos, max);
+        }
+
+        buffer->position = (size_t)(next - buffer->data);
+
+        if( next == end )
+        {
+            if( router_buffer_fill(env, buffer) == FALSE )
+            {
+                return(EOF);
+            }
+
+            continue;
+        }
+
+        inchar = router_buffer_get_ch(env, buffer);
+
+        if( inchar == '"' )
+        {
+            return(inchar);
+        }
+
+        if( inchar == '\\' )
+        {
+            inchar = router_buffer_get_ch(env, buffer);
+
+            if( countLines && ((inchar == '\n') || (inchar == '\r')))
+            {
+                core_inc_line_count(env);
+            }
+        }
+
+        *theString = core_gc_expand_string(env, inchar, *theString, pos, max, *max + 80);
+    }
+}
+
 /*************************************
  * ScanNumber: Scans a numeric token.
  **************************************/
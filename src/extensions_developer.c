@@ -18,6 +18,7 @@
 #include "modules_query.h"
 #include "router.h"
 #include "core_gc.h"
+#include "type_list.h"
 
 #if OBJECT_SYSTEM
 #include "funcs_instance.h"
@@ -36,6 +37,8 @@ void DeveloperCommands(void *env)
     core_define_function(env, "primitives-usage", 'v', PTR_FN PrimitiveTablesUsage, "PrimitiveTablesUsage", "00");
     core_define_function(env, "enable-gc-heuristics", 'v', PTR_FN EnableGCHeuristics, "EnableGCHeuristics", "00");
     core_define_function(env, "disable-gc-heuristics", 'v', PTR_FN DisableGCHeuristics, "DisableGCHeuristics", "00");
+    core_define_function(env, "list-generations", 'v', PTR_FN ListGenerationsInfo, "ListGenerationsInfo", "00");
+    core_define_function(env, "memory-classes", 'v', PTR_FN MemoryClassesInfo, "MemoryClassesInfo", "00");
 
 #if OBJECT_SYSTEM
     core_define_function(env, "instance-table-usage", 'v', PTR_FN InstanceTableUsage, "InstanceTableUsage", "00");
@@ -60,6 +63,86 @@ void DisableGCHeuristics(void *env)
     core_gc_set_is_using_gc_heuristics(env, FALSE);
 }
 
+/*****************************************************
+ * ListGenerationsInfo: Prints the number of garbage
+ *   lists held at each evaluation depth along with
+ *   the current garbage collection thresholds.
+ ******************************************************/
+void ListGenerationsInfo(void *env)
+{
+    int i;
+    long count, size;
+
+    core_check_arg_count(env, "list-generations", EXACTLY, 0);
+
+    for( i = 0; i < get_list_generation_count(env); i++ )
+    {
+        get_list_generation_stats(env, i, &count, &size);
+
+        if( count == 0 )
+        {
+            continue;
+        }
+
+        print_router(env, WDISPLAY, "Depth ");
+        core_print_long(env, WDISPLAY, (long long)i);
+        print_router(env, WDISPLAY, ": ");
+        core_print_long(env, WDISPLAY, (long long)count);
+        print_router(env, WDISPLAY, " lists, ");
+        core_print_long(env, WDISPLAY, (long long)size);
+        print_router(env, WDISPLAY, " bytes\n");
+    }
+
+    print_router(env, WDISPLAY, "Items: ");
+    core_print_long(env, WDISPLAY, (long long)core_get_gc_data(env)->generational_item_count);
+    print_router(env, WDISPLAY, " of ");
+    core_print_long(env, WDISPLAY, (long long)core_get_gc_data(env)->generational_item_count_max);
+    print_router(env, WDISPLAY, "\n");
+    print_router(env, WDISPLAY, "Bytes: ");
+    core_print_long(env, WDISPLAY, (long long)core_get_gc_data(env)->generational_item_sz);
+    print_router(env, WDISPLAY, " of ");
+    core_print_long(env, WDISPLAY, (long long)core_get_gc_data(env)->generational_item_sz_max);
+    print_router(env, WDISPLAY, "\n");
+}
+
+/*****************************************************
+ * MemoryClassesInfo: Prints the slabs, objects in
+ *   use and objects available for each size class
+ *   of the memory allocator that has any slabs.
+ ******************************************************/
+void MemoryClassesInfo(void *env)
+{
+    int i;
+    size_t objectSize;
+    long slabs, inUse, available;
+
+    core_check_arg_count(env, "memory-classes", EXACTLY, 0);
+
+    for( i = 1; i < core_mem_get_class_count(); i++ )
+    {
+        core_mem_get_class_stats(env, i, &objectSize, &slabs, &inUse, &available);
+
+        if( slabs == 0 )
+        {
+            continue;
+        }
+
+        print_router(env, WDISPLAY, "Size ");
+        core_print_long(env, WDISPLAY, (long long)objectSize);
+        print_router(env, WDISPLAY, ": ");
+        core_print_long(env, WDISPLAY, (long long)slabs);
+        print_router(env, WDISPLAY, " slabs, ");
+        core_print_long(env, WDISPLAY, (long long)inUse);
+        print_router(env, WDISPLAY, " in use, ");
+        core_print_long(env, WDISPLAY, (long long)available);
+        print_router(env, WDISPLAY, " available\n");
+    }
+
+    print_router(env, WDISPLAY, "Pool: ");
+    core_print_long(env, WDISPLAY, (long long)core_mem_get_pool_sz(env));
+    print_router(env, WDISPLAY, " bytes\n");
+}
+
 /*****************************************************
  * PrimitiveTablesInfo: Prints information about the
  *   symbol, float, integer, and bitmap tables.
@@ -82,7 +165,7 @@ void PrimitiveTablesInfo(void *env)
 
     symbolArray = get_symbol_table(env);
 
-    for( i = 0; i < ATOM_HASH_SZ; i++ )
+    for( i = 0; i < get_symbol_table_size(env); i++ )
     {
         for( symbolPtr = symbolArray[i]; symbolPtr != NULL; symbolPtr = symbolPtr->next )
         {
@@ -96,7 +179,7 @@ void PrimitiveTablesInfo(void *env)
 
     integerArray = get_integer_table(env);
 
-    for( i = 0; i < INTEGER_HASH_SZ; i++ )
+    for( i = 0; i < get_integer_table_size(env); i++ )
     {
         for( integerPtr = integerArray[i]; integerPtr != NULL; integerPtr = integerPtr->next )
         {
@@ -110,7 +193,7 @@ void PrimitiveTablesInfo(void *env)
 
     floatArray = get_float_table(env);
 
-    for( i = 0; i < FLOAT_HASH_SZ; i++ )
+    for( i = 0; i < get_float_table_size(env); i++ )
     {
         for( floatPtr = floatArray[i]; floatPtr != NULL; floatPtr = floatPtr->next )
         {
@@ -185,7 +268,7 @@ void PrimitiveTablesUsage(void *env)
 
     symbolArray = get_symbol_table(env);
 
-    for( i = 0; i < ATOM_HASH_SZ; i++ )
+    for( i = 0; i < get_symbol_table_size(env); i++ )
     {
         symbolCount = 0;
 
@@ -211,7 +294,7 @@ void PrimitiveTablesUsage(void *env)
 
     floatArray = get_float_table(env);
 
-    for( i = 0; i < FLOAT_HASH_SZ; i++ )
+    for( i = 0; i < get_float_table_size(env); i++ )
     {
         floatCount = 0;
 
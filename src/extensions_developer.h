@@ -17,6 +17,8 @@ LOCALE void PrimitiveTablesInfo(void *);
 LOCALE void PrimitiveTablesUsage(void *);
 LOCALE void EnableGCHeuristics(void *);
 LOCALE void DisableGCHeuristics(void *);
+LOCALE void ListGenerationsInfo(void *);
+LOCALE void MemoryClassesInfo(void *);
 
 #if OBJECT_SYSTEM
 LOCALE void InstanceTableUsage(void *);
@@ -26,6 +26,13 @@ void func_init_comparisons(void *env)
     core_define_function(env, ">=", 'b', broccoli_greater_than_or_equal, "broccoli_greater_than_or_equal", "2*n");
     core_define_function(env, "<", 'b', broccoli_less_than, "broccoli_less_than", "2*n");
     core_define_function(env, ">", 'b', broccoli_greater_than, "broccoli_greater_than", "2*n");
+
+    core_set_function_pure(env, FUNC_NAME_EQUAL, TRUE);
+    core_set_function_pure(env, FUNC_NAME_NOT_EQUAL, TRUE);
+    core_set_function_pure(env, "<=", TRUE);
+    core_set_function_pure(env, ">=", TRUE);
+    core_set_function_pure(env, "<", TRUE);
+    core_set_function_pure(env, ">", TRUE);
 }
 
 /***********************************
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #define _STDIO_INCLUDED_
+#include <string.h>
 
 #include "setup.h"
 
@@ -28,7 +29,11 @@
  * LOCAL FUNCTION PROTOTYPES
  ***************************************/
 
-static void _delete_flow_control_data(void *);
+static void    _delete_flow_control_data(void *);
+static void    _set_binding_slot(void *, int, BOOLEAN, core_data_object_ptr);
+static BOOLEAN _get_binding_slot(void *, void *, core_data_object *);
+static BOOLEAN _put_binding_slot(void *, void *, core_data_object *);
+static void    _grow_binding_slots(void *);
 
 /*********************************************
  * func_init_flow_control: Initializes
@@ -36,8 +41,18 @@ static void _delete_flow_control_data(void *);
  **********************************************/
 void func_init_flow_control(void *env)
 {
+    core_data_entity_object bindingGetInfo = {"BINDING_SLOT_META", BINDING_SLOT_META, 0,    1,    0,    NULL,    NULL,    NULL,
+                                              _get_binding_slot,   NULL,              NULL, NULL, NULL, NULL,    NULL,    NULL,    NULL},
+                            bindingSetInfo = {"BINDING_SLOT",      BINDING_SLOT,      0,    1,    0,    NULL,    NULL,    NULL,
+                                              _put_binding_slot,   NULL,              NULL, NULL, NULL, NULL,    NULL,    NULL,    NULL};
+
     core_allocate_environment_data(env, FLOW_CONTROL_DATA_INDEX, sizeof(struct flow_control_data), _delete_flow_control_data);
 
+    memcpy(&get_flow_control_data(env)->binding_get_info, &bindingGetInfo, sizeof(struct core_data_entity));
+    memcpy(&get_flow_control_data(env)->binding_set_info, &bindingSetInfo, sizeof(struct core_data_entity));
+    core_install_primitive(env, &get_flow_control_data(env)->binding_get_info, BINDING_SLOT_META);
+    core_install_primitive(env, &get_flow_control_data(env)->binding_set_info, BINDING_SLOT);
+
     core_define_function(env, FUNC_NAME_ASSIGNMENT, RT_UNKNOWN, PTR_FN broccoli_bind, "broccoli_bind", FUNC_CNSTR_ASSIGNMENT);
     core_define_function(env, "if", RT_UNKNOWN, PTR_FN broccoli_if, "broccoli_if", NULL);
     core_define_function(env, FUNC_NAME_PROGN, RT_UNKNOWN, PTR_FN broccoli_progn, "broccoli_progn", FUNC_CNSTR_PROGN);
@@ -45,6 +60,8 @@ void func_init_flow_control(void *env)
     init_flow_control_parsers(env);
     core_set_function_overload(env, FUNC_NAME_PROGN, FALSE, FALSE);
     core_set_function_overload(env, "if", FALSE, FALSE);
+    core_set_function_lazy(env, FUNC_NAME_PROGN, TRUE);
+    core_set_function_lazy(env, "(get-loop-count)", TRUE);
 
     core_add_reset_listener(env, FUNC_NAME_ASSIGNMENT, flush_bindings, 0);
     core_add_clear_fn(env, FUNC_NAME_ASSIGNMENT, flush_bindings, 0);
@@ -56,15 +73,144 @@ void func_init_flow_control(void *env)
  *************************************************************/
 static void _delete_flow_control_data(void *env)
 {
-    core_data_object_ptr nextPtr, garbagePtr;
+    struct flow_control_data *data = get_flow_control_data(env);
+
+    if( data->binding_max > 0 )
+    {
+        core_mem_free(env, data->bindings, sizeof(struct core_data) * data->binding_max);
+        core_mem_free(env, data->binding_names, sizeof(ATOM_HN *) * data->binding_max);
+        core_mem_free(env, data->binding_table, sizeof(int) * data->binding_table_size);
+    }
+}
+
+/*****************************************************
+ * find_binding_slot: Returns the 1-based frame slot
+ *   assigned to a variable name, or 0 if the name
+ *   has no slot. Slots are assigned once per name
+ *   and are never reused, so an index handed out at
+ *   parse time stays valid for the life of the
+ *   environment. Names are found through an open
+ *   addressed table of slots hashed on the name.
+ ******************************************************/
+int find_binding_slot(void *env, ATOM_HN *varName, BOOLEAN create)
+{
+    struct flow_control_data *data = get_flow_control_data(env);
+    int i, slot;
+
+    if( data->binding_table_size == 0 )
+    {
+        if( create == FALSE )
+        {
+            return(0);
+        }
+
+        _grow_binding_slots(env);
+    }
+
+    i = (int)(((size_t)varName >> 3) & (size_t)(data->binding_table_size - 1));
+
+    while((slot = data->binding_table[i]) != 0 )
+    {
+        if( data->binding_names[slot - 1] == varName )
+        {
+            return(slot);
+        }
+
+        i = (i + 1) & (data->binding_table_size - 1);
+    }
+
+    if( create == FALSE )
+    {
+        return(0);
+    }
+
+    if( data->binding_count == data->binding_max )
+    {
+        _grow_binding_slots(env);
+        return(find_binding_slot(env, varName, TRUE));
+    }
+
+    data->bindings[data->binding_count].type = ATOM;
+    data->bindings[data->binding_count].value = get_false(env);
+    data->bindings[data->binding_count].metadata = get_false(env);
+    data->bindings[data->binding_count].next = NULL;
+    data->binding_names[data->binding_count] = varName;
+    inc_atom_count(varName);
+    data->binding_table[i] = ++data->binding_count;
+
+    return(data->binding_count);
+}
+
+/*****************************************************
+ * _grow_binding_slots: Doubles the number of frame
+ *   slots and rehashes the names into a table twice
+ *   that size, so it is never more than half full.
+ ******************************************************/
+static void _grow_binding_slots(void *env)
+{
+    struct flow_control_data *data = get_flow_control_data(env);
+    int newMax, slot, i;
+
+    newMax = (data->binding_max == 0) ? 16 : data->binding_max * 2;
+    data->bindings = (struct core_data *)
+                     core_mem_realloc(env, data->bindings, sizeof(struct core_data) * data->binding_max,
+                                      sizeof(struct core_data) * newMax);
+    data->binding_names = (ATOM_HN **)
+                          core_mem_realloc(env, data->binding_names, sizeof(ATOM_HN *) * data->binding_max,
+                                           sizeof(ATOM_HN *) * newMax);
+    data->binding_max = newMax;
+
+    if( data->binding_table != NULL )
+    {
+        core_mem_free(env, data->binding_table, sizeof(int) * data->binding_table_size);
+    }
+
+    data->binding_table_size = newMax * 2;
+    data->binding_table = (int *)core_mem_alloc_and_init(env, sizeof(int) * data->binding_table_size);
+
+    for( slot = 1; slot <= data->binding_count; slot++ )
+    {
+        i = (int)(((size_t)data->binding_names[slot - 1] >> 3) & (size_t)(data->binding_table_size - 1));
+
+        while( data->binding_table[i] != 0 )
+        {
+            i = (i + 1) & (data->binding_table_size - 1);
+        }
+
+        data->binding_table[i] = slot;
+    }
+}
+
+/*****************************************************
+ * _set_binding_slot: Stores the value in ret into a
+ *   frame slot, or unbinds the slot if unbindVar is
+ *   TRUE.
+ ******************************************************/
+static void _set_binding_slot(void *env, int slot, BOOLEAN unbindVar, core_data_object_ptr ret)
+{
+    core_data_object_ptr theBind;
 
-    garbagePtr = get_flow_control_data(env)->variables;
+    theBind = &get_flow_control_data(env)->bindings[slot - 1];
 
-    while( garbagePtr != NULL )
+    if( theBind->metadata == get_true(env))
     {
-        nextPtr = garbagePtr->next;
-        core_mem_return_struct(env, core_data, garbagePtr);
-        garbagePtr = nextPtr;
+        core_value_decrement(env, theBind);
+    }
+
+    if( unbindVar == FALSE )
+    {
+        theBind->metadata = get_true(env);
+        theBind->type = ret->type;
+        theBind->value = ret->value;
+        theBind->begin = ret->begin;
+        theBind->end = ret->end;
+        core_value_increment(env, ret);
+    }
+    else
+    {
+        theBind->metadata = get_false(env);
+        ret->type = ATOM;
+        ret->value = get_false(env);
     }
 }
 
@@ -74,9 +220,7 @@ static void _delete_flow_control_data(void *env)
  **************************************/
 void broccoli_bind(void *env, core_data_object_ptr ret)
 {
-    core_data_object *theBind, *lastBind;
-    int found = FALSE,
-        unbindVar = FALSE;
+    int unbindVar = FALSE, slot;
     ATOM_HN *variableName = NULL;
 
     /*===============================================
@@ -102,91 +246,21 @@ void broccoli_bind(void *env, core_data_object_ptr ret)
         add_to_list(env, ret, core_get_first_arg()->next_arg, TRUE);
     }
 
-
     /*===============================================
-     * Search for the variable in the list of binds.
+     * Unbinding a variable that was never bound
+     * does not need a frame slot.
      *===============================================*/
 
-    theBind = get_flow_control_data(env)->variables;
-    lastBind = NULL;
-
-    while((theBind != NULL) && (found == FALSE))
-    {
-        if( theBind->metadata == (void *)variableName )
-        {
-            found = TRUE;
-        }
-        else
-        {
-            lastBind = theBind;
-            theBind = theBind->next;
-        }
-    }
-
-    /*========================================================
-     * If variable was not in the list of binds, then add it.
-     * Make sure that this operation preserves the bind list
-     * as a stack.
-     *========================================================*/
+    slot = find_binding_slot(env, variableName, (BOOLEAN)(unbindVar == FALSE));
 
-    if( found == FALSE )
+    if( slot == 0 )
     {
-        if( unbindVar == FALSE )
-        {
-            theBind = core_mem_get_struct(env, core_data);
-            theBind->metadata = (void *)variableName;
-            inc_atom_count(variableName);
-            theBind->next = NULL;
-
-            if( lastBind == NULL )
-            {
-                get_flow_control_data(env)->variables = theBind;
-            }
-            else
-            {
-                lastBind->next = theBind;
-            }
-        }
-        else
-        {
-            ret->type = ATOM;
-            ret->value = get_false(env);
-            return;
-        }
-    }
-    else
-    {
-        core_value_decrement(env, theBind);
-    }
-
-    /*================================
-     * Set the value of the variable.
-     *================================*/
-
-    if( unbindVar == FALSE )
-    {
-        theBind->type = ret->type;
-        theBind->value = ret->value;
-        theBind->begin = ret->begin;
-        theBind->end = ret->end;
-        core_value_increment(env, ret);
-    }
-    else
-    {
-        if( lastBind == NULL )
-        {
-            get_flow_control_data(env)->variables = theBind->next;
-        }
-        else
-        {
-            lastBind->next = theBind->next;
-        }
-
-        dec_atom_count(env, (struct atom_hash_node *)theBind->metadata);
-        core_mem_return_struct(env, core_data, theBind);
         ret->type = ATOM;
         ret->value = get_false(env);
+        return;
     }
+
+    _set_binding_slot(env, slot, unbindVar, ret);
 }
 
 /******************************************
@@ -196,30 +270,106 @@ void broccoli_bind(void *env, core_data_object_ptr ret)
 BOOLEAN lookup_binding(void *env, core_data_object_ptr vPtr, ATOM_HN *varName)
 {
     core_data_object_ptr bindPtr;
+    int slot;
 
-    for( bindPtr = get_flow_control_data(env)->variables; bindPtr != NULL; bindPtr = bindPtr->next )
+    if((slot = find_binding_slot(env, varName, FALSE)) == 0 )
     {
-        if( bindPtr->metadata == (void *)varName )
-        {
-            vPtr->type = bindPtr->type;
-            vPtr->value = bindPtr->value;
-            vPtr->begin = bindPtr->begin;
-            vPtr->end = bindPtr->end;
-            return(TRUE);
-        }
+        return(FALSE);
     }
 
-    return(FALSE);
+    bindPtr = &get_flow_control_data(env)->bindings[slot - 1];
+
+    if( bindPtr->metadata != get_true(env))
+    {
+        return(FALSE);
+    }
+
+    vPtr->type = bindPtr->type;
+    vPtr->value = bindPtr->value;
+    vPtr->begin = bindPtr->begin;
+    vPtr->end = bindPtr->end;
+    return(TRUE);
 }
 
 /************************************************
  * flush_bindings: Removes all variables from the
  *   list of currently bound local variables.
+ *   The slots themselves are kept, since parsed
+ *   expressions may still refer to them.
  *************************************************/
 void flush_bindings(void *env)
 {
-    core_release_data(env, get_flow_control_data(env)->variables, TRUE);
-    get_flow_control_data(env)->variables = NULL;
+    struct flow_control_data *data = get_flow_control_data(env);
+    int i;
+
+    for( i = 0; i < data->binding_count; i++ )
+    {
+        if( data->bindings[i].metadata == get_true(env))
+        {
+            core_value_decrement(env, &data->bindings[i]);
+            data->bindings[i].metadata = get_false(env);
+        }
+    }
+}
+
+/*************************************************
+ * _get_binding_slot: Evaluation function for a
+ *   BINDING_SLOT_META expression, a reference to
+ *   a top level variable whose frame slot was
+ *   resolved when the command or eval string
+ *   was parsed.
+ **************************************************/
+static BOOLEAN _get_binding_slot(void *env, void *value, core_data_object *ret)
+{
+    core_data_object_ptr bindPtr;
+
+    bindPtr = &get_flow_control_data(env)->bindings[*((int *)to_bitmap(value)) - 1];
+
+    if( bindPtr->metadata == get_true(env))
+    {
+        ret->type = bindPtr->type;
+        ret->value = bindPtr->value;
+        ret->begin = bindPtr->begin;
+        ret->end = bindPtr->end;
+        return(TRUE);
+    }
+
+    error_print_id(env, ERROR_TAG_EVALUATION, 1, FALSE);
+    print_router(env, WERROR, ERROR_MSG_VAR_UNBOUND);
+    print_router(env, WERROR, to_string(core_get_first_arg()->value));
+    print_router(env, WERROR, ".\n");
+    ret->type = ATOM;
+    ret->value = get_false(env);
+    core_set_eval_error(env, TRUE);
+    return(TRUE);
+}
+
+/*************************************************
+ * _put_binding_slot: Evaluation function for a
+ *   BINDING_SLOT expression, a call to the bind
+ *   function whose variable was resolved to a
+ *   frame slot when the command or eval string
+ *   was parsed.
+ **************************************************/
+static BOOLEAN _put_binding_slot(void *env, void *value, core_data_object *ret)
+{
+    int unbindVar = FALSE;
+
+    if( core_get_first_arg() == NULL )
+    {
+        unbindVar = TRUE;
+    }
+    else if( core_get_first_arg()->next_arg == NULL )
+    {
+        core_eval_expression(env, core_get_first_arg(), ret);
+    }
+    else
+    {
+        add_to_list(env, ret, core_get_first_arg(), TRUE);
+    }
+
+    _set_binding_slot(env, *((int *)to_bitmap(value)), unbindVar, ret);
+    return(TRUE);
 }
 
 /**************************************
@@ -28,7 +28,14 @@ struct flow_control_data
     int               return_flag;
     int               break_flag;
     LOOP_COUNT_STACK *loop_count_stack;
-    struct core_data *variables;
+    struct core_data *bindings;
+    struct atom_hash_node **binding_names;
+    int               binding_count;
+    int               binding_max;
+    int *             binding_table;
+    int               binding_table_size;
+    struct core_data_entity binding_get_info;
+    struct core_data_entity binding_set_info;
 };
 
 #define get_flow_control_data(env) ((struct flow_control_data *)core_get_environment_data(env, FLOW_CONTROL_DATA_INDEX))
@@ -38,6 +45,7 @@ LOCALE void broccoli_bind(void *, core_data_object_ptr);
 LOCALE void broccoli_if(void *, core_data_object_ptr);
 LOCALE void broccoli_progn(void *, core_data_object_ptr);
 LOCALE BOOLEAN   lookup_binding(void *, struct core_data *, struct atom_hash_node *);
+LOCALE int       find_binding_slot(void *, struct atom_hash_node *, BOOLEAN);
 LOCALE long long broccoli_get_loop_count(void *);
 LOCALE void      flush_bindings(void *);
 
@@ -26,6 +26,9 @@
 #include "core_memory.h"
 #include "core_constructs_query.h"
 #include "router.h"
+#if BYTECODE_FUNCTIONS
+#include "core_bytecode.h"
+#endif
 
 #define __FUNCS_FUNCTIONS_SOURCE__
 #include "funcs_function.h"
@@ -169,6 +172,9 @@ static void _delete_function(void *env, struct construct_metadata *cons, void *b
     }
 
     core_return_packed_expression(env, theDeffunction->code);
+#if BYTECODE_FUNCTIONS
+    core_bytecode_release(env, theDeffunction->bytecode);
+#endif
 
     core_delete_construct_metadata(env, &theDeffunction->header);
 
@@ -292,9 +298,13 @@ void remove_function(void *env, void *vdptr)
     dec_atom_count(env, get_function_name_ptr((void *)dptr));
     core_decrement_expression(env, dptr->code);
     core_return_packed_expression(env, dptr->code);
+#if BYTECODE_FUNCTIONS
+    core_bytecode_release(env, dptr->bytecode);
+#endif
     set_function_pp((void *)dptr, NULL);
     ext_clear_data(env, dptr->header.ext_data);
     core_mem_return_struct(env, function_definition, dptr);
+    core_invalidate_function_cache(env);
 }
 
 /********************************************************
@@ -579,6 +589,10 @@ static BOOLEAN _remove_all_functions(void *env)
             dptr->busy = oldbusy;
             core_return_packed_expression(env, dptr->code);
             dptr->code = NULL;
+#if BYTECODE_FUNCTIONS
+            core_bytecode_release(env, dptr->bytecode);
+            dptr->bytecode = NULL;
+#endif
         }
 
         dptr = (FUNCTION_DEFINITION *)get_next_function(env, (void *)dptr);
@@ -8,6 +8,8 @@
 #define get_function_metadata(env, x) core_garner_module((struct construct_metadata *)x)
 
 typedef struct function_definition FUNCTION_DEFINITION;
+
+struct core_bytecode;
 typedef struct function_module     FUNCTION_MODULE;
 
 #ifndef __CORE_CONSTRUCTS_QUERY_H__
@@ -47,11 +49,32 @@ struct function_definition
     unsigned                  executing;
     unsigned short            trace;
     core_expression_object *  code;
+#if BYTECODE_FUNCTIONS
+    struct core_bytecode *    bytecode;
+#endif
     int                       min_args,
                               max_args,
                               local_variable_count;
 };
 
+/*==================================================
+ * A deffunction call in tail position is not made
+ * by the body. The bytecode loop or the walker
+ * leaves the callee and its argument values here
+ * and returns, and function_execute runs the
+ * callee in the frame it already has. The argument
+ * expressions are linked DATA_OBJECT_VALUE nodes
+ * over the values.
+ *==================================================*/
+struct function_tail_call
+{
+    FUNCTION_DEFINITION *   function;
+    int                     argc;
+    int                     size;
+    core_data_object *      values;
+    core_expression_object *args;
+};
+
 #define FUNCTION_DATA_INDEX 23
 
 struct function_data
@@ -65,6 +88,7 @@ struct function_data
     struct CodeGeneratorItem *code_generation_item;
     FUNCTION_DEFINITION *     executing_function;
     struct token              input_token;
+    struct function_tail_call *tail_call;
 };
 
 #define get_function_data(env) ((struct function_data *)core_get_environment_data(env, FUNCTION_DATA_INDEX))
@@ -113,7 +113,8 @@ static void _delete_io_data(void *env)
 
         if( theEntry->type == FILE_SOURCE )
         {
-            sysdep_close_file(env, (FILE *)get_io_data(env)->TopOfBatchList->source);
+            sysdep_close_file(env, ((struct router_buffer *)theEntry->source)->file);
+            router_buffer_close(env, (struct router_buffer *)theEntry->source);
         }
         else
         {
@@ -176,7 +177,7 @@ int io_get_ch_from_batch(void *env, char *logicalName, int returnOnEOF)
     {
         if( get_io_data(env)->BatchType == FILE_SOURCE )
         {
-            rv = getc((FILE *)get_io_data(env)->BatchSource);
+            rv = router_buffer_get_ch(env, (struct router_buffer *)get_io_data(env)->BatchSource);
         }
         else
         {
@@ -276,7 +277,7 @@ static int _unget_ch_batch(void *env, int ch, char *logicalName)
 
     if( get_io_data(env)->BatchType == FILE_SOURCE )
     {
-        return(ungetc(ch, (FILE *)get_io_data(env)->BatchSource));
+        return(router_buffer_unget_ch((struct router_buffer *)get_io_data(env)->BatchSource, ch));
     }
 
     return(unget_ch_router(env, ch, (char *)get_io_data(env)->BatchSource));
@@ -353,10 +354,11 @@ int io_open_batch(void *env, char *fileName, int placeAtEnd)
 
     /*====================================
      * Add the newly opened batch file to
-     * the list of batch files opened.
+     * the list of batch files opened. It
+     * is read through a router buffer.
      *====================================*/
 
-    _add_batch(env, placeAtEnd, (void *)theFile, FILE_SOURCE, NULL);
+    _add_batch(env, placeAtEnd, (void *)router_buffer_open(env, theFile), FILE_SOURCE, NULL);
 
     /*===================================
      * Return TRUE to indicate the batch
@@ -430,7 +432,8 @@ int io_pop_batch(void *env)
 
     if( get_io_data(env)->TopOfBatchList->type == FILE_SOURCE )
     {
-        sysdep_close_file(env, (FILE *)get_io_data(env)->TopOfBatchList->source);
+        sysdep_close_file(env, ((struct router_buffer *)get_io_data(env)->TopOfBatchList->source)->file);
+        router_buffer_close(env, (struct router_buffer *)get_io_data(env)->TopOfBatchList->source);
     }
     else
     {
@@ -759,6 +762,7 @@ void init_io_all_functions(void *env)
     inc_atom_count(get_io_locale_data(env)->locale);
 
     core_define_function(env, "print", RT_VOID, PTR_FN broccoli_print, "PrintoutFunction", "1*");
+    core_define_function(env, "flush", RT_BOOL, PTR_FN broccoli_flush, "broccoli_flush", "*1");
 
 #if IO_FUNCTIONS
     core_define_function(env, "read",       'u', PTR_FN ReadFunction,  "ReadFunction", "*1");
@@ -876,6 +880,52 @@ void broccoli_print(void *env)
     }
 }
 
+/*****************************************
+ * broccoli_flush: H/L access routine
+ *   for the flush function. Writes out
+ *   anything buffered for the given
+ *   logical name, or for all of them.
+ ******************************************/
+int broccoli_flush(void *env)
+{
+    int argCount;
+    char *logicalName;
+
+    if((argCount = core_check_arg_count(env, "flush", NO_MORE_THAN, 1)) == -1 )
+    {
+        return(FALSE);
+    }
+
+    if( argCount == 0 )
+    {
+        flush_all_files(env);
+        return(TRUE);
+    }
+
+    logicalName = core_lookup_logical_name(env, 1, "stdout");
+
+    if( logicalName == NULL )
+    {
+        report_logical_name_lookup_error(env, "flush");
+        core_set_halt_eval(env, TRUE);
+        core_set_eval_error(env, TRUE);
+        return(FALSE);
+    }
+
+    /*=================================================
+     * Routers other than the file router do not
+     * buffer, so there is nothing to do for them.
+     *=================================================*/
+
+    if( flush_file(env, logicalName) || query_router(env, logicalName))
+    {
+        return(TRUE);
+    }
+
+    error_unknown_router(env, logicalName);
+    return(FALSE);
+}
+
 #if IO_FUNCTIONS
 
 /****************************************************
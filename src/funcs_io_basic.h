@@ -27,6 +27,7 @@ LOCALE int     broccoli_run_silent(void *, char *);
 LOCALE int     broccoli_import(void *);
 LOCALE void    init_io_all_functions(void *);
 LOCALE void    broccoli_print(void *);
+LOCALE int     broccoli_flush(void *);
 
 #if IO_FUNCTIONS
 LOCALE BOOLEAN SetFullCRLF(void *, BOOLEAN);
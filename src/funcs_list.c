@@ -81,6 +81,8 @@ void init_list_functions(void *env)
     core_define_function(env, "len",          'g', PTR_FN broccoli_length,      "broccoli_length", "11q");
 
     core_add_function_parser(env, FUNC_NAME_FOREACH, _foreach_parser);
+    core_set_function_lazy(env, FUNC_NAME_PROGN_VAR, TRUE);
+    core_set_function_lazy(env, FUNC_NAME_PROGN_INDEX, TRUE);
 }
 
 /*****************************************************************
@@ -18,6 +18,13 @@ void init_logic_functions(void *env)
     core_define_function(env, FUNC_NAME_NOT, RT_BOOL, broccoli_not, "broccoli_not", FUNC_CNSTR_NOT);
     core_define_function(env, FUNC_NAME_AND, RT_BOOL, broccoli_and, "broccoli_and", FUNC_CNSTR_AND);
     core_define_function(env, FUNC_NAME_OR, RT_BOOL, broccoli_or, "broccoli_or", FUNC_CNSTR_OR);
+
+    core_set_function_pure(env, FUNC_NAME_NOT, TRUE);
+    core_set_function_pure(env, FUNC_NAME_AND, TRUE);
+    core_set_function_pure(env, FUNC_NAME_OR, TRUE);
+
+    core_set_function_lazy(env, FUNC_NAME_AND, TRUE);
+    core_set_function_lazy(env, FUNC_NAME_OR, TRUE);
 }
 
 /************************************
@@ -36,6 +36,13 @@ void init_basic_math_functions(void *env)
     core_define_function(env, FUNC_NAME_DIV, RT_INT_FLOAT, PTR_FN broccoli_division, "DivisionFunction", FUNC_CNSTR_DIV);
     core_define_function(env, FUNC_NAME_CAST_INT, RT_LONG_LONG, PTR_FN broccoli_convert_to_integer, "IntegerFunction", FUNC_CNSTR_CAST_INT);
     core_define_function(env, FUNC_NAME_CAST_FLOAT, RT_DOUBLE, PTR_FN broccoli_covert_to_float, "FloatFunction", FUNC_CNSTR_CAST_FLOAT);
+
+    core_set_function_pure(env, FUNC_NAME_ADD, TRUE);
+    core_set_function_pure(env, FUNC_NAME_MULT, TRUE);
+    core_set_function_pure(env, FUNC_NAME_SUB, TRUE);
+    core_set_function_pure(env, FUNC_NAME_DIV, TRUE);
+    core_set_function_pure(env, FUNC_NAME_CAST_INT, TRUE);
+    core_set_function_pure(env, FUNC_NAME_CAST_FLOAT, TRUE);
 }
 
 /*********************************
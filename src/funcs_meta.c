@@ -41,7 +41,6 @@ void broccoli_call(void *env, core_data_object *ret)
     int argCount, i, j;
     core_data_object val;
     FUNCTION_REFERENCE ref;
-    char *name;
     struct list *list;
     struct core_expression *lastAdd = NULL, *nextAdd, *multiAdd;
     struct core_function_definition *func;
@@ -72,13 +71,12 @@ void broccoli_call(void *env, core_data_object *ret)
         return;
     }
 
-    /*====================
-     * Find the function.
-     *====================*/
+    /*===================================
+     * Find the function. The reference
+     * is cached for its name.
+     *===================================*/
 
-    name = core_convert_data_to_string(val);
-
-    if( !core_get_function_referrence(env, name, &ref))
+    if( !core_get_cached_function_referrence(env, (ATOM_HN *)core_get_value(val), &ref))
     {
         report_explicit_type_error(env, "funcall", 1, "function, deffunction, or generic function name");
         return;
@@ -91,7 +89,7 @@ void broccoli_call(void *env, core_data_object *ret)
 
     if( ref.type == FCALL )
     {
-        func = core_lookup_function(env, name);
+        func = (struct core_function_definition *)ref.value;
 
         if( func->parser != NULL )
         {
@@ -307,6 +305,7 @@ int _eval(void *env, char *theString, core_data_object_ptr ret)
     static int depth = 0;
     char logicalNameBuffer[20];
     struct binding *oldBinds;
+    struct core_mem_region_mark region;
 
     /*======================================================
      * Evaluate the string. Create a different logical name
@@ -338,8 +337,16 @@ int _eval(void *env, char *theString, core_data_object_ptr ret)
      * Parse the string argument passed to the eval function.
      *========================================================*/
 
+    core_mem_region_begin(env, &region);
     top = parse_atom_or_expression(env, logicalNameBuffer, NULL);
 
+    if((top != NULL) && (top->type != LIST_VARIABLE))
+    {
+        resolve_parsed_bindings(env, top);
+    }
+
+    core_mem_region_stop(env, &region);
+
     /*============================
      * Restore the parsing state.
      *============================*/
@@ -358,6 +365,7 @@ int _eval(void *env, char *theString, core_data_object_ptr ret)
         close_string_source(env, logicalNameBuffer);
         core_set_pointer_type(ret, ATOM);
         core_set_pointer_value(ret, get_false(env));
+        core_mem_region_end(env, &region);
         depth--;
         return(FALSE);
     }
@@ -375,7 +383,7 @@ int _eval(void *env, char *theString, core_data_object_ptr ret)
         close_string_source(env, logicalNameBuffer);
         core_set_pointer_type(ret, ATOM);
         core_set_pointer_value(ret, get_false(env));
-        core_return_expression(env, top);
+        core_mem_region_end(env, &region);
         depth--;
         return(FALSE);
     }
@@ -393,7 +401,7 @@ int _eval(void *env, char *theString, core_data_object_ptr ret)
         close_string_source(env, logicalNameBuffer);
         core_set_pointer_type(ret, ATOM);
         core_set_pointer_value(ret, get_false(env));
-        core_return_expression(env, top);
+        core_mem_region_end(env, &region);
         depth--;
         return(FALSE);
     }
@@ -408,7 +416,7 @@ int _eval(void *env, char *theString, core_data_object_ptr ret)
     core_decrement_expression(env, top);
 
     depth--;
-    core_return_expression(env, top);
+    core_mem_region_end(env, &region);
     close_string_source(env, logicalNameBuffer);
 
     /*==========================================
@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 #define _STDIO_INCLUDED_
+#include <stdlib.h>
 #include <string.h>
 
 #include "setup.h"
@@ -35,6 +36,7 @@ struct misc_function_data
  ***************************************/
 static void _expand_function_list(void *, core_data_object *, core_expression_object *, core_expression_object **, void *);
 static void _dummy_expand(void *, core_data_object *);
+static int  _compare_times(const void *, const void *);
 
 
 /****************************************************************
@@ -46,9 +48,14 @@ void init_misc_functions(void *env)
     get_misc_function_data(env)->sequence_number = 1;
 
     core_define_function(env, "bench", 'd', PTR_FN broccoli_bench, "TimerFunction", "**");
+    core_define_function(env, FUNC_NAME_BENCHMARK, RT_DOUBLE, PTR_FN broccoli_benchmark, "broccoli_benchmark", FUNC_CNSTR_BENCHMARK);
     core_define_function(env, FUNC_NAME_EXPAND_META, RT_UNKNOWN, PTR_FN broccoli_expand, "ExpandFuncCall", FUNC_CNSTR_EXPAND_META);
     core_define_function(env, FUNC_NAME_EXPAND, RT_UNKNOWN, PTR_FN _dummy_expand, "DummyExpandFuncList", FUNC_CNSTR_EXPAND);
     core_set_function_overload(env, FUNC_NAME_EXPAND, FALSE, FALSE);
+    core_set_function_lazy(env, "bench", TRUE);
+    core_set_function_lazy(env, FUNC_NAME_BENCHMARK, TRUE);
+    core_set_function_lazy(env, FUNC_NAME_EXPAND_META, TRUE);
+    core_set_function_lazy(env, FUNC_NAME_EXPAND, TRUE);
 }
 
 /********************************************************************
@@ -85,7 +92,7 @@ void broccoli_expand(void *env, core_data_object *result)
      *  Build the new function call expression with the expanded arguments.
      *  Check the number of arguments, if necessary, and call the thing.
      *  =================================================================== */
-    fcallexp = core_mem_get_struct(env, core_expression);
+    fcallexp = core_get_expression_node(env);
     fcallexp->type = core_get_first_arg()->type;
     fcallexp->value = core_get_first_arg()->value;
     fcallexp->next_arg = NULL;
@@ -196,7 +203,7 @@ static void _expand_function_list(void *env, core_data_object *result, core_expr
 
             for( i = core_get_data_ptr_start(result) ; i <= core_get_data_ptr_end(result) ; i++ )
             {
-                newexp = core_mem_get_struct(env, core_expression);
+                newexp = core_get_expression_node(env);
                 newexp->type = get_list_node_type(result->value, i);
                 newexp->value = get_list_node_value(result->value, i);
                 newexp->args = NULL;
@@ -217,14 +224,14 @@ static void _expand_function_list(void *env, core_data_object *result, core_expr
             if( top == NULL )
             {
                 *sto = theExp->next_arg;
-                core_mem_return_struct(env, core_expression, theExp);
+                core_return_expression_node(env, theExp);
                 theExp = *sto;
             }
             else
             {
                 bot->next_arg = theExp->next_arg;
                 *sto = top;
-                core_mem_return_struct(env, core_expression, theExp);
+                core_return_expression_node(env, theExp);
                 sto = &bot->next_arg;
                 theExp = bot->next_arg;
             }
@@ -262,3 +269,128 @@ double broccoli_bench(void *env)
 
     return(sysdep_time() - startTime);
 }
+
+/*****************************************************
+ * broccoli_benchmark: H/L access routine for the
+ *   benchmark function. Evaluates the last argument
+ *   for the given number of warm up runs, then times
+ *   each of the measured runs with the monotonic
+ *   clock. A JSON object with the median and 95th
+ *   percentile wall times and the memory and garbage
+ *   collection counts of the measured runs is printed
+ *   to wdisplay. mem_calls and mem_amount are the
+ *   allocations made; the held figures are the signed
+ *   net change in memory held from the system, which
+ *   is negative when a collection during the runs
+ *   gives back more than they kept. Returns the
+ *   median in seconds.
+ ******************************************************/
+double broccoli_benchmark(void *env)
+{
+    core_data_object arg, ret;
+    char *name;
+    long long warmups, runs, i, *times, start;
+    long calls, amount, heldCalls, heldAmount, collections;
+    char buffer[512];
+
+    core_get_arg_at(env, 1, &arg);
+
+    if((core_get_type(arg) != STRING) && (core_get_type(arg) != ATOM))
+    {
+        report_explicit_type_error(env, FUNC_NAME_BENCHMARK, 1, "symbol or string");
+        core_set_eval_error(env, TRUE);
+        return(-1.0);
+    }
+
+    name = core_convert_data_to_string(arg);
+
+    if( core_check_arg_type(env, FUNC_NAME_BENCHMARK, 2, INTEGER, &arg) == FALSE )
+    {
+        return(-1.0);
+    }
+
+    warmups = core_convert_data_to_long(arg);
+
+    if( core_check_arg_type(env, FUNC_NAME_BENCHMARK, 3, INTEGER, &arg) == FALSE )
+    {
+        return(-1.0);
+    }
+
+    runs = core_convert_data_to_long(arg);
+
+    if((warmups < 0) || (runs < 1))
+    {
+        if( warmups < 0 )
+        {
+            report_explicit_type_error(env, FUNC_NAME_BENCHMARK, 2, "non-negative integer");
+        }
+        else
+        {
+            report_explicit_type_error(env, FUNC_NAME_BENCHMARK, 3, "positive integer");
+        }
+
+        core_set_eval_error(env, TRUE);
+        return(-1.0);
+    }
+
+    for( i = 0; (i < warmups) && (core_get_halt_eval(env) != TRUE); i++ )
+    {
+        core_get_arg_at(env, 4, &ret);
+    }
+
+    times = (long long *)core_mem_alloc_no_init(env, sizeof(long long) * (size_t)runs);
+    calls = core_mem_get_memory_data(env)->allocations;
+    amount = core_mem_get_memory_data(env)->allocated;
+    heldCalls = core_mem_get_memory_data(env)->calls;
+    heldAmount = core_mem_get_memory_data(env)->amount;
+    collections = core_get_gc_data(env)->collections;
+
+    for( i = 0; i < runs; i++ )
+    {
+        start = sysdep_clock_ns();
+
+        if( core_get_halt_eval(env) != TRUE )
+        {
+            core_get_arg_at(env, 4, &ret);
+        }
+
+        times[i] = sysdep_clock_ns() - start;
+    }
+
+    calls = core_mem_get_memory_data(env)->allocations - calls;
+    amount = core_mem_get_memory_data(env)->allocated - amount;
+    heldCalls = core_mem_get_memory_data(env)->calls - heldCalls;
+    heldAmount = core_mem_get_memory_data(env)->amount - heldAmount;
+    collections = core_get_gc_data(env)->collections - collections;
+
+    qsort(times, (size_t)runs, sizeof(long long), _compare_times);
+
+    /*=================================================
+     * Percentiles use the nearest rank, so that they
+     * are always one of the times that was measured.
+     *=================================================*/
+    print_router(env, WDISPLAY, "{\"name\": \"");
+    print_router(env, WDISPLAY, name);
+    sysdep_sprintf(buffer, "\", \"warmups\": %lld, \"runs\": %lld, \"median_ns\": %lld, \"p95_ns\": %lld, "
+                   "\"min_ns\": %lld, \"max_ns\": %lld, \"mem_calls\": %ld, \"mem_amount\": %ld, "
+                   "\"mem_held_calls\": %ld, \"mem_held_amount\": %ld, \"gc_count\": %ld}\n",
+                   warmups, runs, times[(runs - 1) / 2], times[(runs * 95 + 99) / 100 - 1],
+                   times[0], times[runs - 1], calls, amount, heldCalls, heldAmount, collections);
+    print_router(env, WDISPLAY, buffer);
+
+    start = times[(runs - 1) / 2];
+    core_mem_release(env, times, sizeof(long long) * (size_t)runs);
+
+    return((double)start / 1000000000.0);
+}
+
+/*********************************************
+ * _compare_times: qsort comparison routine for
+ *   the benchmark run times.
+ **********************************************/
+static int _compare_times(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+
+    return((x < y) ? -1 : ((x > y) ? 1 : 0));
+}
@@ -15,5 +15,9 @@
 LOCALE void   init_misc_functions(void *);
 LOCALE void   broccoli_expand(void *, core_data_object *);
 LOCALE double broccoli_bench(void *);
+LOCALE double broccoli_benchmark(void *);
+
+#define FUNC_NAME_BENCHMARK  "benchmark"
+#define FUNC_CNSTR_BENCHMARK "44"
 
 #endif
@@ -8,26 +8,48 @@
 #if PROFILING_FUNCTIONS
 
 #include "core_arguments.h"
-#include "classes_kernel.h"
 #include "funcs_function.h"
 #include "core_environment.h"
 #include "core_functions.h"
-#include "generics_kernel.h"
-#include "funcs_generics.h"
 #include "core_memory.h"
-#include "classes_methods_kernel.h"
 #include "router.h"
 #include "sysdep.h"
 
+#if OBJECT_SYSTEM
+#include "classes_kernel.h"
+#include "classes_methods_kernel.h"
+#endif
+
+#if DEFGENERIC_CONSTRUCT
+#include "generics_kernel.h"
+#include "funcs_generics.h"
+#endif
+
 #include "funcs_profiling.h"
 
 #include <string.h>
+#include <time.h>
 
 #define NO_PROFILE      0
 #define USER_FUNCTIONS  1
 #define CONSTRUCTS_CODE 2
 
-#define OUTPUT_STRING "%-40s %7ld %15.6f  %8.2f%%  %15.6f  %8.2f%%\n"
+#define OUTPUT_STRING "%-40s %7ld %15.9f  %8.2f%%  %15.9f  %8.2f%%  %10lld  %10lld  %10lld  %10lld  %10lld\n"
+
+#define NANOSECONDS_PER_SECOND 1000000000.0
+
+/*=================================================
+ * The cycle counter is only read where the compiler
+ * and processor are known. It is calibrated against
+ * the monotonic clock when first selected.
+ *=================================================*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PROFILE_CYCLE_COUNTER 1
+#else
+#define PROFILE_CYCLE_COUNTER 0
+#endif
+
+#define CYCLE_CALIBRATION_NS 20000000LL
 
 /**************************************
  * LOCAL FUNCTION PROTOTYPES
@@ -37,6 +59,14 @@ static BOOLEAN OutputProfileInfo(void *, char *, struct constructProfileInfo *,
 static void    OutputUserFunctionsInfo(void *);
 static void    OutputConstructsCodeInfo(void *);
 static void    ProfileClearFunction(void *);
+static void    RecordCallTime(void *, struct constructProfileInfo *, long long);
+static int     HistogramIndex(long long);
+static long long HistogramPercentile(struct constructProfileInfo *, double);
+static long long ProcessorClock(void);
+#if PROFILE_CYCLE_COUNTER
+static long long CycleClock(void);
+static double    CalibrateCycleClock(void);
+#endif
 
 /*****************************************************
  * ConstructProfilingFunctionDefinitions: Initializes
@@ -56,6 +86,7 @@ void ConstructProfilingFunctionDefinitions(void *env)
     ProfileFunctionData(env)->LastProfileInfo = NO_PROFILE;
     ProfileFunctionData(env)->PercentThreshold = 0.0;
     ProfileFunctionData(env)->OutputString = OUTPUT_STRING;
+    SetProfileClock(env, "monotonic");
 
     core_define_function(env, "profile", 'v', PTR_FN ProfileCommand, "ProfileCommand", "11w");
     core_define_function(env, "profile-info", 'v', PTR_FN ProfileInfoCommand, "ProfileInfoCommand", "01w");
@@ -67,6 +98,12 @@ void ConstructProfilingFunctionDefinitions(void *env)
     core_define_function(env, "get-profile-percent-threshold", 'd',
                          PTR_FN GetProfilePercentThresholdCommand,
                          "GetProfilePercentThresholdCommand", "00");
+    core_define_function(env, "set-profile-clock", 'b',
+                         PTR_FN SetProfileClockCommand,
+                         "SetProfileClockCommand", "11w");
+    core_define_function(env, "get-profile-clock", 'w',
+                         PTR_FN GetProfileClockCommand,
+                         "GetProfileClockCommand", "00");
 
     ProfileFunctionData(env)->ProfileDataID = ext_install_record(env, &ProfileFunctionData(env)->ProfileDataInfo);
 
@@ -84,11 +121,8 @@ void *CreateProfileData(void *env)
     theInfo = (struct constructProfileInfo *)
               core_mem_alloc(env, sizeof(struct constructProfileInfo));
 
-    theInfo->numberOfEntries = 0;
-    theInfo->childCall = FALSE;
-    theInfo->startTime = 0.0;
-    theInfo->totalSelfTime = 0.0;
-    theInfo->totalWithChildrenTime = 0.0;
+    theInfo->histogram = NULL;
+    ResetProfileInfo(theInfo);
 
     return(theInfo);
 }
@@ -98,6 +132,13 @@ void *CreateProfileData(void *env)
  **************************************/
 void DeleteProfileData(void *env, void *data)
 {
+    struct constructProfileInfo *theInfo = (struct constructProfileInfo *)data;
+
+    if( theInfo->histogram != NULL )
+    {
+        core_mem_free(env, theInfo->histogram, sizeof(unsigned long) * PROFILE_HISTOGRAM_SIZE);
+    }
+
     core_mem_free(env, data, sizeof(struct constructProfileInfo));
 }
 
@@ -147,7 +188,7 @@ BOOLEAN Profile(void *env, char *argument)
 
     if( strcmp(argument, "user-functions") == 0 )
     {
-        ProfileFunctionData(env)->ProfileStartTime = sysdep_time();
+        ProfileFunctionData(env)->ProfileStartTime = (*ProfileFunctionData(env)->ClockFunction)();
         ProfileFunctionData(env)->ProfileUserFunctions = TRUE;
         ProfileFunctionData(env)->ProfileConstructs = FALSE;
         ProfileFunctionData(env)->LastProfileInfo = USER_FUNCTIONS;
@@ -155,7 +196,7 @@ BOOLEAN Profile(void *env, char *argument)
 
     else if( strcmp(argument, "constructs") == 0 )
     {
-        ProfileFunctionData(env)->ProfileStartTime = sysdep_time();
+        ProfileFunctionData(env)->ProfileStartTime = (*ProfileFunctionData(env)->ClockFunction)();
         ProfileFunctionData(env)->ProfileUserFunctions = FALSE;
         ProfileFunctionData(env)->ProfileConstructs = TRUE;
         ProfileFunctionData(env)->LastProfileInfo = CONSTRUCTS_CODE;
@@ -168,7 +209,7 @@ BOOLEAN Profile(void *env, char *argument)
 
     else if( strcmp(argument, "off") == 0 )
     {
-        ProfileFunctionData(env)->ProfileEndTime = sysdep_time();
+        ProfileFunctionData(env)->ProfileEndTime = (*ProfileFunctionData(env)->ClockFunction)();
         ProfileFunctionData(env)->ProfileTotalTime += (ProfileFunctionData(env)->ProfileEndTime - ProfileFunctionData(env)->ProfileStartTime);
         ProfileFunctionData(env)->ProfileUserFunctions = FALSE;
         ProfileFunctionData(env)->ProfileConstructs = FALSE;
@@ -227,7 +268,7 @@ void ProfileInfoCommand(void *env)
 
     if( ProfileFunctionData(env)->ProfileUserFunctions || ProfileFunctionData(env)->ProfileConstructs )
     {
-        ProfileFunctionData(env)->ProfileEndTime = sysdep_time();
+        ProfileFunctionData(env)->ProfileEndTime = (*ProfileFunctionData(env)->ClockFunction)();
         ProfileFunctionData(env)->ProfileTotalTime += (ProfileFunctionData(env)->ProfileEndTime - ProfileFunctionData(env)->ProfileStartTime);
     }
 
@@ -237,8 +278,10 @@ void ProfileInfoCommand(void *env)
 
     if( ProfileFunctionData(env)->LastProfileInfo != NO_PROFILE )
     {
-        sysdep_sprintf(buffer, "Profile elapsed time = %g seconds\n",
-                       ProfileFunctionData(env)->ProfileTotalTime);
+        sysdep_sprintf(buffer, "Profile elapsed time = %.9f seconds (%s clock)\n",
+                       ((double)ProfileFunctionData(env)->ProfileTotalTime *
+                        ProfileFunctionData(env)->NanosecondsPerTick) / NANOSECONDS_PER_SECOND,
+                       ProfileFunctionData(env)->ClockName);
         print_router(env, WDISPLAY, buffer);
 
         if( ProfileFunctionData(env)->LastProfileInfo == USER_FUNCTIONS )
@@ -250,7 +293,7 @@ void ProfileInfoCommand(void *env)
             print_router(env, WDISPLAY, "Construct Name                           ");
         }
 
-        print_router(env, WDISPLAY, "Entries         Time           %          Time+Kids     %+Kids\n");
+        print_router(env, WDISPLAY, "Entries         Time           %          Time+Kids     %+Kids      Min ns      P50 ns      P90 ns      P99 ns      Max ns\n");
 
         if( ProfileFunctionData(env)->LastProfileInfo == USER_FUNCTIONS )
         {
@@ -261,7 +304,7 @@ void ProfileInfoCommand(void *env)
             print_router(env, WDISPLAY, "--------------                           ");
         }
 
-        print_router(env, WDISPLAY, "-------        ------        -----        ---------     ------\n");
+        print_router(env, WDISPLAY, "-------        ------        -----        ---------     ------      ------      ------      ------      ------      ------\n");
     }
 
     if( ProfileFunctionData(env)->LastProfileInfo == USER_FUNCTIONS )
@@ -281,7 +324,7 @@ void ProfileInfoCommand(void *env)
  **********************************************/
 void StartProfile(void *env, struct profileFrameInfo *theFrame, struct ext_data **list, BOOLEAN checkFlag)
 {
-    double startTime, addTime;
+    long long startTime, addTime;
     struct constructProfileInfo *profileInfo;
 
     if( !checkFlag )
@@ -295,7 +338,8 @@ void StartProfile(void *env, struct profileFrameInfo *theFrame, struct ext_data
     theFrame->profileOnExit = TRUE;
     theFrame->parentCall = FALSE;
 
-    startTime = sysdep_time();
+    startTime = (*ProfileFunctionData(env)->ClockFunction)();
+    theFrame->callStartTime = startTime;
     theFrame->oldProfileFrame = ProfileFunctionData(env)->ActiveProfileFrame;
 
     if( ProfileFunctionData(env)->ActiveProfileFrame != NULL )
@@ -323,14 +367,14 @@ void StartProfile(void *env, struct profileFrameInfo *theFrame, struct ext_data
  *******************************************/
 void EndProfile(void *env, struct profileFrameInfo *theFrame)
 {
-    double endTime, addTime;
+    long long endTime, addTime;
 
     if( !theFrame->profileOnExit )
     {
         return;
     }
 
-    endTime = sysdep_time();
+    endTime = (*ProfileFunctionData(env)->ClockFunction)();
 
     if( theFrame->parentCall )
     {
@@ -340,6 +384,7 @@ void EndProfile(void *env, struct profileFrameInfo *theFrame)
     }
 
     ProfileFunctionData(env)->ActiveProfileFrame->totalSelfTime += (endTime - ProfileFunctionData(env)->ActiveProfileFrame->startTime);
+    RecordCallTime(env, ProfileFunctionData(env)->ActiveProfileFrame, endTime - theFrame->callStartTime);
 
     if( theFrame->oldProfileFrame != NULL )
     {
@@ -355,7 +400,7 @@ void EndProfile(void *env, struct profileFrameInfo *theFrame)
  ******************************************/
 static BOOLEAN OutputProfileInfo(void *env, char *itemName, struct constructProfileInfo *profileInfo, char *printPrefixBefore, char *printPrefix, char *printPrefixAfter, char **banner)
 {
-    double percent = 0.0, percentWithKids = 0.0;
+    double percent = 0.0, percentWithKids = 0.0, toSeconds;
     char buffer[512];
 
     if( profileInfo == NULL )
@@ -368,16 +413,16 @@ static BOOLEAN OutputProfileInfo(void *env, char *itemName, struct constructProf
         return(FALSE);
     }
 
-    if( ProfileFunctionData(env)->ProfileTotalTime != 0.0 )
+    if( ProfileFunctionData(env)->ProfileTotalTime != 0 )
     {
-        percent = (profileInfo->totalSelfTime * 100.0) / ProfileFunctionData(env)->ProfileTotalTime;
+        percent = ((double)profileInfo->totalSelfTime * 100.0) / (double)ProfileFunctionData(env)->ProfileTotalTime;
 
         if( percent < 0.005 )
         {
             percent = 0.0;
         }
 
-        percentWithKids = (profileInfo->totalWithChildrenTime * 100.0) / ProfileFunctionData(env)->ProfileTotalTime;
+        percentWithKids = ((double)profileInfo->totalWithChildrenTime * 100.0) / (double)ProfileFunctionData(env)->ProfileTotalTime;
 
         if( percentWithKids < 0.005 )
         {
@@ -418,15 +463,23 @@ static BOOLEAN OutputProfileInfo(void *env, char *itemName, struct constructProf
         itemName = "";
     }
 
+    toSeconds = ProfileFunctionData(env)->NanosecondsPerTick / NANOSECONDS_PER_SECOND;
+
     sysdep_sprintf(buffer, ProfileFunctionData(env)->OutputString,
                    itemName,
                    (long)profileInfo->numberOfEntries,
 
-                   (double)profileInfo->totalSelfTime,
+                   (double)profileInfo->totalSelfTime * toSeconds,
                    (double)percent,
 
-                   (double)profileInfo->totalWithChildrenTime,
-                   (double)percentWithKids);
+                   (double)profileInfo->totalWithChildrenTime * toSeconds,
+                   (double)percentWithKids,
+
+                   profileInfo->minCallTime,
+                   HistogramPercentile(profileInfo, 0.50),
+                   HistogramPercentile(profileInfo, 0.90),
+                   HistogramPercentile(profileInfo, 0.99),
+                   profileInfo->maxCallTime);
     print_router(env, WDISPLAY, buffer);
 
     return(TRUE);
@@ -455,9 +508,9 @@ void ProfileResetCommand(void *env)
     unsigned handlerIndex;
 #endif
 
-    ProfileFunctionData(env)->ProfileStartTime = 0.0;
-    ProfileFunctionData(env)->ProfileEndTime = 0.0;
-    ProfileFunctionData(env)->ProfileTotalTime = 0.0;
+    ProfileFunctionData(env)->ProfileStartTime = 0;
+    ProfileFunctionData(env)->ProfileEndTime = 0;
+    ProfileFunctionData(env)->ProfileTotalTime = 0;
     ProfileFunctionData(env)->LastProfileInfo = NO_PROFILE;
 
     for( func = core_get_function_list(env);
@@ -546,9 +599,142 @@ void ResetProfileInfo(struct constructProfileInfo *profileInfo)
 
     profileInfo->numberOfEntries = 0;
     profileInfo->childCall = FALSE;
-    profileInfo->startTime = 0.0;
-    profileInfo->totalSelfTime = 0.0;
-    profileInfo->totalWithChildrenTime = 0.0;
+    profileInfo->startTime = 0;
+    profileInfo->totalSelfTime = 0;
+    profileInfo->totalWithChildrenTime = 0;
+    profileInfo->minCallTime = 0;
+    profileInfo->maxCallTime = 0;
+    profileInfo->recordedCalls = 0;
+
+    if( profileInfo->histogram != NULL )
+    {
+        memset(profileInfo->histogram, 0, sizeof(unsigned long) * PROFILE_HISTOGRAM_SIZE);
+    }
+}
+
+/**************************************************
+ * RecordCallTime: Adds the duration of one call,
+ *   given in clock ticks, to the call statistics.
+ *   The statistics themselves are in nanoseconds.
+ ***************************************************/
+static void RecordCallTime(void *env, struct constructProfileInfo *profileInfo, long long ticks)
+{
+    long long ns;
+
+    ns = (long long)((double)ticks * ProfileFunctionData(env)->NanosecondsPerTick);
+
+    if( ns < 0 )
+    {
+        ns = 0;
+    }
+
+    /*=================================================
+     * numberOfEntries counts calls as they start, so a
+     * nested call can finish first. The min is seeded
+     * by the first call recorded instead.
+     *=================================================*/
+    if((profileInfo->recordedCalls == 0) || (ns < profileInfo->minCallTime))
+    {
+        profileInfo->minCallTime = ns;
+    }
+
+    if( ns > profileInfo->maxCallTime )
+    {
+        profileInfo->maxCallTime = ns;
+    }
+
+    if( profileInfo->histogram == NULL )
+    {
+        profileInfo->histogram = (unsigned long *)
+                                 core_mem_alloc_and_init(env, sizeof(unsigned long) * PROFILE_HISTOGRAM_SIZE);
+    }
+
+    profileInfo->recordedCalls++;
+    profileInfo->histogram[HistogramIndex(ns)]++;
+}
+
+/**************************************************
+ * HistogramIndex: Maps a duration to its bucket.
+ *   Values below PROFILE_HISTOGRAM_SUB get a bucket
+ *   each; above that every power of two is split
+ *   into PROFILE_HISTOGRAM_SUB equal buckets.
+ ***************************************************/
+static int HistogramIndex(long long ns)
+{
+    int msb;
+    unsigned long long value = (unsigned long long)ns;
+
+    if( value < PROFILE_HISTOGRAM_SUB )
+    {
+        return((int)value);
+    }
+
+    for( msb = 0; (value >> msb) > 1; msb++ )
+    {
+        /* Find the highest bit set. */
+    }
+
+    return((msb - PROFILE_HISTOGRAM_BITS + 1) * PROFILE_HISTOGRAM_SUB +
+           (int)((value >> (msb - PROFILE_HISTOGRAM_BITS)) & (PROFILE_HISTOGRAM_SUB - 1)));
+}
+
+/**************************************************
+ * HistogramPercentile: Estimates the duration in
+ *   nanoseconds below which the given fraction of
+ *   the calls fall, using the middle of the bucket
+ *   the percentile lands in.
+ ***************************************************/
+static long long HistogramPercentile(struct constructProfileInfo *profileInfo, double fraction)
+{
+    unsigned long total, target, seen = 0;
+    long long low, width, estimate;
+    int i, msb;
+
+    total = profileInfo->recordedCalls;
+
+    if((total == 0) || (profileInfo->histogram == NULL))
+    {
+        return(0);
+    }
+
+    target = (unsigned long)(fraction * (double)total);
+
+    if( target >= total )
+    {
+        target = total - 1;
+    }
+
+    for( i = 0; i < PROFILE_HISTOGRAM_SIZE; i++ )
+    {
+        seen += profileInfo->histogram[i];
+
+        if( seen > target )
+        {
+            break;
+        }
+    }
+
+    if( i < PROFILE_HISTOGRAM_SUB )
+    {
+        return((long long)i);
+    }
+
+    msb = i / PROFILE_HISTOGRAM_SUB + PROFILE_HISTOGRAM_BITS - 1;
+    width = 1LL << (msb - PROFILE_HISTOGRAM_BITS);
+    low = (long long)(PROFILE_HISTOGRAM_SUB + i % PROFILE_HISTOGRAM_SUB) * width;
+    estimate = low + width / 2;
+
+    if( estimate < profileInfo->minCallTime )
+    {
+        estimate = profileInfo->minCallTime;
+    }
+
+    if( estimate > profileInfo->maxCallTime )
+    {
+        estimate = profileInfo->maxCallTime;
+    }
+
+    return(estimate);
 }
 
 /************************************************
@@ -794,6 +980,145 @@ char *SetProfileOutputString(void *env, char *value)
     return(oldOutputString);
 }
 
+/*************************************************
+ * SetProfileClockCommand: H/L access routine for
+ *   the set-profile-clock command.
+ **************************************************/
+int SetProfileClockCommand(void *env)
+{
+    core_data_object val;
+
+    if( core_check_arg_count(env, "set-profile-clock", EXACTLY, 1) == -1 )
+    {
+        return(FALSE);
+    }
+
+    if( core_check_arg_type(env, "set-profile-clock", 1, ATOM, &val) == FALSE )
+    {
+        return(FALSE);
+    }
+
+    if( !SetProfileClock(env, core_convert_data_to_string(val)))
+    {
+#if PROFILE_CYCLE_COUNTER
+        report_explicit_type_error(env, "set-profile-clock", 1, "symbol with value monotonic, cycles, or cpu");
+#else
+        report_explicit_type_error(env, "set-profile-clock", 1, "symbol with value monotonic or cpu");
+#endif
+        return(FALSE);
+    }
+
+    return(TRUE);
+}
+
+/*************************************************
+ * GetProfileClockCommand: H/L access routine for
+ *   the get-profile-clock command.
+ **************************************************/
+void *GetProfileClockCommand(void *env)
+{
+    core_check_arg_count(env, "get-profile-clock", EXACTLY, 0);
+
+    return(store_atom(env, ProfileFunctionData(env)->ClockName));
+}
+
+/*****************************************************
+ * SetProfileClock: C access routine for the
+ *   set-profile-clock command. Selects the source of
+ *   the profile times: monotonic wall clock time,
+ *   processor cycles or processor time. Gathered
+ *   profile information is reset since it was taken
+ *   in ticks of the old clock.
+ ******************************************************/
+BOOLEAN SetProfileClock(void *env, char *clockName)
+{
+    if( strcmp(clockName, "monotonic") == 0 )
+    {
+        ProfileFunctionData(env)->ClockName = "monotonic";
+        ProfileFunctionData(env)->ClockFunction = sysdep_clock_ns;
+        ProfileFunctionData(env)->NanosecondsPerTick = 1.0;
+    }
+#if PROFILE_CYCLE_COUNTER
+    else if( strcmp(clockName, "cycles") == 0 )
+    {
+        ProfileFunctionData(env)->ClockName = "cycles";
+        ProfileFunctionData(env)->ClockFunction = CycleClock;
+        ProfileFunctionData(env)->NanosecondsPerTick = CalibrateCycleClock();
+    }
+#endif
+    else if( strcmp(clockName, "cpu") == 0 )
+    {
+        ProfileFunctionData(env)->ClockName = "cpu";
+        ProfileFunctionData(env)->ClockFunction = ProcessorClock;
+        ProfileFunctionData(env)->NanosecondsPerTick = NANOSECONDS_PER_SECOND / (double)CLOCKS_PER_SEC;
+    }
+    else
+    {
+        return(FALSE);
+    }
+
+    if( ProfileFunctionData(env)->LastProfileInfo != NO_PROFILE )
+    {
+        ProfileResetCommand(env);
+    }
+
+    return(TRUE);
+}
+
+/*******************************************
+ * ProcessorClock: Processor time in clock
+ *   ticks, as the profiler used to measure.
+ ********************************************/
+static long long ProcessorClock()
+{
+    return((long long)clock());
+}
+
+#if PROFILE_CYCLE_COUNTER
+
+/*******************************************
+ * CycleClock: Reads the processor's time
+ *   stamp counter.
+ ********************************************/
+static long long CycleClock()
+{
+    unsigned int low, high;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+
+    return((long long)(((unsigned long long)high << 32) | low));
+}
+
+/*************************************************
+ * CalibrateCycleClock: Returns the nanoseconds
+ *   per cycle counter tick, measured against the
+ *   monotonic clock over CYCLE_CALIBRATION_NS.
+ **************************************************/
+static double CalibrateCycleClock()
+{
+    long long startNs, endNs, startTicks, endTicks;
+
+    startNs = sysdep_clock_ns();
+    startTicks = CycleClock();
+
+    do
+    {
+        endNs = sysdep_clock_ns();
+    }
+    while((endNs - startNs) < CYCLE_CALIBRATION_NS );
+
+    endTicks = CycleClock();
+
+    if( endTicks <= startTicks )
+    {
+        return(1.0);
+    }
+
+    return((double)(endNs - startNs) / (double)(endTicks - startTicks));
+}
+
+#endif /* PROFILE_CYCLE_COUNTER */
+
 /*****************************************************************
  * ProfileClearFunction: Profiling clear routine for use with the
  *   clear command. Removes user data attached to user functions.
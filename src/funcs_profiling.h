@@ -13,15 +13,34 @@
 
 #include "extensions_data.h"
 #if PROFILING_FUNCTIONS
+
+/*==================================================
+ * Times are kept in ticks of the selected profile
+ * clock and converted to nanoseconds on output. The
+ * duration of each call, kids included, goes into
+ * a histogram with PROFILE_HISTOGRAM_SUB buckets
+ * per power of two nanoseconds, from which the
+ * percentiles are estimated. The histogram is only
+ * allocated once a call has been recorded, so that
+ * functions never run under profile cost nothing.
+ *==================================================*/
+#define PROFILE_HISTOGRAM_BITS 2
+#define PROFILE_HISTOGRAM_SUB  (1 << PROFILE_HISTOGRAM_BITS)
+#define PROFILE_HISTOGRAM_SIZE (64 * PROFILE_HISTOGRAM_SUB)
+
 struct constructProfileInfo
 {
     struct ext_data ext_datum;
     long            numberOfEntries;
     unsigned int    childCall :
     1;
-    double startTime;
-    double totalSelfTime;
-    double totalWithChildrenTime;
+    long long     startTime;
+    long long     totalSelfTime;
+    long long     totalWithChildrenTime;
+    long long     minCallTime;
+    long long     maxCallTime;
+    unsigned long recordedCalls;
+    unsigned long *histogram;
 };
 
 struct profileFrameInfo
@@ -30,7 +49,8 @@ struct profileFrameInfo
     1;
     unsigned int profileOnExit :
     1;
-    double                       parentStartTime;
+    long long                    parentStartTime;
+    long long                    callStartTime;
     struct constructProfileInfo *oldProfileFrame;
 };
 
@@ -38,9 +58,9 @@ struct profileFrameInfo
 
 struct profileFunctionData
 {
-    double                       ProfileStartTime;
-    double                       ProfileEndTime;
-    double                       ProfileTotalTime;
+    long long                    ProfileStartTime;
+    long long                    ProfileEndTime;
+    long long                    ProfileTotalTime;
     int                          LastProfileInfo;
     double                       PercentThreshold;
     struct ext_data_record       ProfileDataInfo;
@@ -49,6 +69,9 @@ struct profileFunctionData
     int                          ProfileConstructs;
     struct constructProfileInfo *ActiveProfileFrame;
     char *                       OutputString;
+    char *                       ClockName;
+    long long                    (*ClockFunction)(void);
+    double                       NanosecondsPerTick;
 };
 
 #define ProfileFunctionData(env) ((struct profileFunctionData *)core_get_environment_data(env, PROFLFUN_DATA))
@@ -72,6 +95,9 @@ LOCALE BOOLEAN                         Profile(void *, char *);
 LOCALE void                            DeleteProfileData(void *, void *);
 LOCALE void                          * CreateProfileData(void *);
 LOCALE char                          * SetProfileOutputString(void *, char *);
+LOCALE int                             SetProfileClockCommand(void *);
+LOCALE void                          * GetProfileClockCommand(void *);
+LOCALE BOOLEAN                         SetProfileClock(void *, char *);
 
 #endif
 #endif
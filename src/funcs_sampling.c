@@ -0,0 +1,485 @@
+/* Purpose: Statistical sampling profiler that records the
+ *   chain of executing deffunctions on a profiling timer
+ *   and writes it out as folded stacks.                   */
+
+#define __FUNCS_SAMPLING_SOURCE__
+
+#include "setup.h"
+
+#if SAMPLING_FUNCTIONS
+
+#include <stdio.h>
+#define _STDIO_INCLUDED_
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "core_arguments.h"
+#include "core_environment.h"
+#include "core_functions.h"
+#include "core_memory.h"
+#include "core_utilities.h"
+#include "router.h"
+#include "sysdep.h"
+
+#include "funcs_sampling.h"
+
+/*==================================================
+ * The profiling timer belongs to the process, so
+ * only one environment samples at a time. The
+ * handler finds it through ActiveSampler.
+ *==================================================*/
+static struct sampling_data *volatile ActiveSampler = NULL;
+static struct sigaction               OldAction;
+static struct itimerval               OldTimer;
+
+/**************************************
+ * LOCAL FUNCTION PROTOTYPES
+ ***************************************/
+static void    _delete_sampling_data(void *);
+static void    _stop_timer(void);
+static void    _release_sampler(void *);
+static void    _sample_handler(int);
+static void    _drain_samples(void *);
+static void    _count_stack(void *, char *, unsigned long);
+static void    _append_key(void *, size_t *, char *);
+static BOOLEAN _write_stacks(void *, char *);
+static void    _free_stacks(void *);
+
+/*********************************************
+ * init_sampling_functions: Initializes the
+ *   sampling profiler and its function.
+ **********************************************/
+void init_sampling_functions(void *env)
+{
+    core_allocate_environment_data(env, SAMPLING_DATA_INDEX, sizeof(struct sampling_data), _delete_sampling_data);
+
+    core_define_function(env, FUNC_NAME_PROFILE_SAMPLE, RT_BOOL, PTR_FN broccoli_profile_sample, "broccoli_profile_sample", FUNC_CNSTR_PROFILE_SAMPLE);
+}
+
+/*************************************************
+ * _delete_sampling_data: Stops a sampler left
+ *   running and throws its samples away.
+ **************************************************/
+static void _delete_sampling_data(void *env)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+
+    if( ActiveSampler == sampler )
+    {
+        _stop_timer();
+        sampler->tail = sampler->head;
+        _release_sampler(env);
+    }
+}
+
+/*************************************************
+ * broccoli_profile_sample: H/L access routine for
+ *   the profile-sample function. Takes start or
+ *   stop and an optional file for the stacks.
+ **************************************************/
+int broccoli_profile_sample(void *env)
+{
+    core_data_object val;
+    char *action, *fileName = NULL;
+
+    if( core_check_arg_type(env, FUNC_NAME_PROFILE_SAMPLE, 1, ATOM, &val) == FALSE )
+    {
+        return(FALSE);
+    }
+
+    action = core_convert_data_to_string(val);
+
+    if( core_get_arg_count(env) == 2 )
+    {
+        if((fileName = core_get_filename(env, FUNC_NAME_PROFILE_SAMPLE, 2)) == NULL )
+        {
+            return(FALSE);
+        }
+    }
+
+    if( strcmp(action, "start") == 0 )
+    {
+        return(sampling_start(env, fileName));
+    }
+    else if( strcmp(action, "stop") == 0 )
+    {
+        return(sampling_stop(env, fileName));
+    }
+
+    report_explicit_type_error(env, FUNC_NAME_PROFILE_SAMPLE, 1, "symbol with value start or stop");
+    return(FALSE);
+}
+
+/****************************************************
+ * sampling_start: C access routine for starting the
+ *   sampler. The file, if given, is where the stacks
+ *   are written when sampling stops.
+ *****************************************************/
+BOOLEAN sampling_start(void *env, char *fileName)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    struct sigaction action;
+    struct itimerval timer;
+
+    if( ActiveSampler != NULL )
+    {
+        error_print_id(env, "SAMPLE", 1, FALSE);
+        print_router(env, WERROR, "The sampling profiler is already running.\n");
+        return(FALSE);
+    }
+
+    sampler->ring = (struct sample_record *)core_mem_alloc_no_init(env, sizeof(struct sample_record) * SAMPLE_RING_SIZE);
+    sampler->stacks = (struct folded_stack **)core_mem_alloc(env, sizeof(struct folded_stack *) * SAMPLE_HASH_SIZE);
+    memset(sampler->stacks, 0, sizeof(struct folded_stack *) * SAMPLE_HASH_SIZE);
+    sampler->head = sampler->tail = 0;
+    sampler->toplevel_count = 0;
+    sampler->dropped_count = 0;
+
+    if( fileName != NULL )
+    {
+        sampler->file_name = (char *)core_mem_alloc_no_init(env, strlen(fileName) + 1);
+        sysdep_strcpy(sampler->file_name, fileName);
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = _sample_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    ActiveSampler = sampler;
+    sigaction(SIGPROF, &action, &OldAction);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = SAMPLE_INTERVAL_USEC;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, &OldTimer);
+
+    return(TRUE);
+}
+
+/****************************************************
+ * sampling_stop: C access routine for stopping the
+ *   sampler. The stacks are written to the file given
+ *   here or else to the one given when it started.
+ *   Returns FALSE if nothing could be written.
+ *****************************************************/
+BOOLEAN sampling_stop(void *env, char *fileName)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    BOOLEAN rv = FALSE;
+
+    if( ActiveSampler != sampler )
+    {
+        return(FALSE);
+    }
+
+    _stop_timer();
+    _drain_samples(env);
+
+    if( fileName == NULL )
+    {
+        fileName = sampler->file_name;
+    }
+
+    if( fileName != NULL )
+    {
+        rv = _write_stacks(env, fileName);
+    }
+
+    _release_sampler(env);
+    return(rv);
+}
+
+/*************************************************
+ * _stop_timer: Stops the profiling timer and puts
+ *   back whatever handled SIGPROF before.
+ **************************************************/
+static void _stop_timer(void)
+{
+    setitimer(ITIMER_PROF, &OldTimer, NULL);
+    sigaction(SIGPROF, &OldAction, NULL);
+    ActiveSampler = NULL;
+}
+
+/*************************************************
+ * _release_sampler: Returns the memory used by a
+ *   stopped sampler.
+ **************************************************/
+static void _release_sampler(void *env)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+
+    _free_stacks(env);
+    core_mem_release(env, sampler->ring, sizeof(struct sample_record) * SAMPLE_RING_SIZE);
+    sampler->ring = NULL;
+    sampler->head = sampler->tail = 0;
+
+    if( sampler->file_name != NULL )
+    {
+        core_mem_release(env, sampler->file_name, strlen(sampler->file_name) + 1);
+        sampler->file_name = NULL;
+    }
+
+    if( sampler->key != NULL )
+    {
+        core_mem_release(env, sampler->key, sampler->key_size);
+        sampler->key = NULL;
+        sampler->key_size = 0;
+    }
+}
+
+/**************************************************
+ * sampling_push_frame: Called as a deffunction
+ *   starts executing. The frame is stored before the
+ *   depth is raised so that the handler never sees a
+ *   slot that has not been filled.
+ ***************************************************/
+void sampling_push_frame(void *env, FUNCTION_DEFINITION *dptr)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+
+    if( sampler->head != sampler->tail )
+    {
+        _drain_samples(env);
+    }
+
+    sampler->frames[sampler->depth & (SAMPLE_MAX_DEPTH - 1)] = dptr;
+    sampler->depth++;
+}
+
+/**************************************************
+ * sampling_pop_frame: Called as a deffunction stops
+ *   executing. Pending samples are drained first, as
+ *   the deffunction may be deleted once it returns.
+ ***************************************************/
+void sampling_pop_frame(void *env)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+
+    if( sampler->head != sampler->tail )
+    {
+        _drain_samples(env);
+    }
+
+    sampler->depth--;
+}
+
+/*************************************************
+ * _sample_handler: SIGPROF handler. Copies the
+ *   innermost frames into the ring without taking
+ *   any lock or allocating. A sample is dropped if
+ *   the ring is full.
+ **************************************************/
+static void _sample_handler(int sig)
+{
+    struct sampling_data *sampler = ActiveSampler;
+    struct sample_record *record;
+    unsigned long depth, first;
+    int i, n;
+
+    if( sampler == NULL )
+    {
+        return;
+    }
+
+    depth = sampler->depth;
+
+    if( depth == 0 )
+    {
+        sampler->toplevel_count++;
+        return;
+    }
+
+    if( sampler->head - sampler->tail >= SAMPLE_RING_SIZE )
+    {
+        sampler->dropped_count++;
+        return;
+    }
+
+    record = &sampler->ring[sampler->head & (SAMPLE_RING_SIZE - 1)];
+    n = (depth < SAMPLE_MAX_DEPTH) ? (int)depth : SAMPLE_MAX_DEPTH;
+    first = depth - (unsigned long)n;
+
+    for( i = 0; i < n; i++ )
+    {
+        record->frames[i] = sampler->frames[(first + (unsigned long)i) & (SAMPLE_MAX_DEPTH - 1)];
+    }
+
+    record->depth = n;
+    record->truncated = (first != 0);
+    sampler->head++;
+}
+
+/*************************************************
+ * _drain_samples: Folds the pending records into
+ *   the stacks hash table, outermost frame first
+ *   as flamegraph.pl expects.
+ **************************************************/
+static void _drain_samples(void *env)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    struct sample_record *record;
+    size_t length;
+    int i;
+
+    while( sampler->tail != sampler->head )
+    {
+        record = &sampler->ring[sampler->tail & (SAMPLE_RING_SIZE - 1)];
+        length = 0;
+
+        if( record->truncated )
+        {
+            _append_key(env, &length, SAMPLE_TRUNCATED_NAME);
+        }
+
+        for( i = 0; i < record->depth; i++ )
+        {
+            _append_key(env, &length, get_function_name(env, (void *)record->frames[i]));
+        }
+
+        _count_stack(env, sampler->key, 1);
+        sampler->tail++;
+    }
+}
+
+/*************************************************
+ * _append_key: Adds a frame to the folded stack
+ *   being built, growing the buffer as needed.
+ **************************************************/
+static void _append_key(void *env, size_t *length, char *name)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    size_t nameLength = strlen(name), newSize;
+    char *newKey;
+
+    if( *length + nameLength + 2 > sampler->key_size )
+    {
+        newSize = (sampler->key_size == 0) ? 256 : sampler->key_size * 2;
+
+        while( *length + nameLength + 2 > newSize )
+        {
+            newSize *= 2;
+        }
+
+        newKey = (char *)core_mem_alloc_no_init(env, newSize);
+
+        if( sampler->key != NULL )
+        {
+            memcpy(newKey, sampler->key, *length + 1);
+            core_mem_release(env, sampler->key, sampler->key_size);
+        }
+
+        sampler->key = newKey;
+        sampler->key_size = newSize;
+    }
+
+    if( *length != 0 )
+    {
+        sampler->key[(*length)++] = ';';
+    }
+
+    memcpy(sampler->key + *length, name, nameLength + 1);
+    *length += nameLength;
+}
+
+/*************************************************
+ * _count_stack: Adds count samples to a folded
+ *   stack, entering it in the table if it is new.
+ **************************************************/
+static void _count_stack(void *env, char *stack, unsigned long count)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    struct folded_stack *entry;
+    unsigned long bucket;
+
+    bucket = hash_atom(stack, SAMPLE_HASH_SIZE);
+
+    for( entry = sampler->stacks[bucket]; entry != NULL; entry = entry->next )
+    {
+        if( strcmp(entry->stack, stack) == 0 )
+        {
+            entry->count += count;
+            return;
+        }
+    }
+
+    entry = core_mem_get_struct(env, folded_stack);
+    entry->size = strlen(stack) + 1;
+    entry->stack = (char *)core_mem_alloc_no_init(env, entry->size);
+    memcpy(entry->stack, stack, entry->size);
+    entry->count = count;
+    entry->next = sampler->stacks[bucket];
+    sampler->stacks[bucket] = entry;
+}
+
+/*************************************************
+ * _write_stacks: Writes one line per folded stack
+ *   followed by its sample count.
+ **************************************************/
+static BOOLEAN _write_stacks(void *env, char *fileName)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    struct folded_stack *entry;
+    FILE *theFile;
+    int i;
+
+    if((theFile = sysdep_open_file(env, fileName, "w")) == NULL )
+    {
+        report_file_open_error(env, FUNC_NAME_PROFILE_SAMPLE, fileName);
+        return(FALSE);
+    }
+
+    if( sampler->toplevel_count != 0 )
+    {
+        fprintf(theFile, "%s %lu\n", SAMPLE_TOPLEVEL_NAME, sampler->toplevel_count);
+    }
+
+    for( i = 0; i < SAMPLE_HASH_SIZE; i++ )
+    {
+        for( entry = sampler->stacks[i]; entry != NULL; entry = entry->next )
+        {
+            fprintf(theFile, "%s %lu\n", entry->stack, entry->count);
+        }
+    }
+
+    sysdep_close_file(env, theFile);
+
+    if( sampler->dropped_count != 0 )
+    {
+        char buffer[30];
+
+        warning_print_id(env, "SAMPLE", 2, FALSE);
+        sysdep_sprintf(buffer, "%lu", sampler->dropped_count);
+        print_router(env, WWARNING, buffer);
+        print_router(env, WWARNING, " samples were dropped.\n");
+    }
+
+    return(TRUE);
+}
+
+/*************************************************
+ * _free_stacks: Returns the memory used by the
+ *   stacks hash table.
+ **************************************************/
+static void _free_stacks(void *env)
+{
+    struct sampling_data *sampler = get_sampling_data(env);
+    struct folded_stack *entry, *next;
+    int i;
+
+    for( i = 0; i < SAMPLE_HASH_SIZE; i++ )
+    {
+        for( entry = sampler->stacks[i]; entry != NULL; entry = next )
+        {
+            next = entry->next;
+            core_mem_release(env, entry->stack, entry->size);
+            core_mem_return_struct(env, folded_stack, entry);
+        }
+    }
+
+    core_mem_release(env, sampler->stacks, sizeof(struct folded_stack *) * SAMPLE_HASH_SIZE);
+    sampler->stacks = NULL;
+}
+
+#endif
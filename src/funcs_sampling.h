@@ -0,0 +1,89 @@
+/* Purpose: Statistical sampling profiler that records the
+ *   chain of executing deffunctions on a profiling timer
+ *   and writes it out as folded stacks.                   */
+
+#ifndef __FUNCS_SAMPLING_H__
+#define __FUNCS_SAMPLING_H__
+
+#ifndef __CORE_EVALUATION_H__
+#include "core_evaluation.h"
+#endif
+#ifndef __FUNCS_FUNCTIONS_H__
+#include "funcs_function.h"
+#endif
+
+#define SAMPLING_DATA_INDEX     16
+#define SAMPLE_MAX_DEPTH        64
+#define SAMPLE_RING_SIZE        1024
+#define SAMPLE_HASH_SIZE        1021
+#define SAMPLE_INTERVAL_USEC    1000
+#define SAMPLE_TOPLEVEL_NAME    "[toplevel]"
+#define SAMPLE_TRUNCATED_NAME   "..."
+
+/*==================================================
+ * The deffunctions being executed are mirrored in
+ * frames, indexed by depth modulo SAMPLE_MAX_DEPTH
+ * so that the innermost calls are always at hand.
+ * The signal handler only copies them into the
+ * next free record of the ring. Records are turned
+ * into folded stacks at the next deffunction entry
+ * or exit, while every frame they name is still
+ * executing, and counted in the stacks hash table.
+ *==================================================*/
+struct sample_record
+{
+    int                  depth;
+    int                  truncated;
+    FUNCTION_DEFINITION *frames[SAMPLE_MAX_DEPTH];
+};
+
+struct folded_stack
+{
+    char *               stack;
+    size_t               size;
+    unsigned long        count;
+    struct folded_stack *next;
+};
+
+struct sampling_data
+{
+    FUNCTION_DEFINITION *volatile frames[SAMPLE_MAX_DEPTH];
+    volatile unsigned long        depth;
+    struct sample_record *        ring;
+    volatile unsigned long        head;
+    volatile unsigned long        tail;
+    volatile unsigned long        toplevel_count;
+    volatile unsigned long        dropped_count;
+    struct folded_stack **        stacks;
+    char *                        file_name;
+    char *                        key;
+    size_t                        key_size;
+};
+
+#define get_sampling_data(env) ((struct sampling_data *)core_get_environment_data(env, SAMPLING_DATA_INDEX))
+
+#ifdef LOCALE
+#undef LOCALE
+#endif
+
+#ifdef __FUNCS_SAMPLING_SOURCE__
+#define LOCALE
+#else
+#define LOCALE extern
+#endif
+
+LOCALE void    init_sampling_functions(void *);
+LOCALE int     broccoli_profile_sample(void *);
+LOCALE BOOLEAN sampling_start(void *, char *);
+LOCALE BOOLEAN sampling_stop(void *, char *);
+LOCALE void    sampling_push_frame(void *, FUNCTION_DEFINITION *);
+LOCALE void    sampling_pop_frame(void *);
+
+/***
+ * Function names and constraints
+ **/
+#define FUNC_NAME_PROFILE_SAMPLE    "profile-sample"
+
+#define FUNC_CNSTR_PROFILE_SAMPLE   "12k"
+
+#endif
@@ -0,0 +1,310 @@
+/* Purpose: Mutable string builders for assembling large
+ *   strings piece by piece without interning every
+ *   intermediate result.                                  */
+
+#define __FUNCS_STRING_BUILDER_SOURCE__
+
+#include "setup.h"
+
+#include <stdio.h>
+#define _STDIO_INCLUDED_
+#include <string.h>
+
+#include "core_arguments.h"
+#include "core_environment.h"
+#include "core_functions.h"
+#include "core_memory.h"
+#include "router.h"
+#include "sysdep.h"
+
+#include "funcs_string_builder.h"
+
+/**************************************
+ * LOCAL FUNCTION PROTOTYPES
+ ***************************************/
+static void                    _delete_string_builder_data(void *);
+static void                    _print_string_builder(void *, char *, void *);
+static BOOLEAN                 _discard_string_builder(void *, void *);
+static struct string_builder * _get_string_builder_arg(void *, char *, core_data_object_ptr);
+static BOOLEAN                 _append_args(void *, char *, struct string_builder *, int);
+static void                    _append_chars(void *, struct string_builder *, char *, size_t);
+static void                    _free_string_builder(void *, struct string_builder *);
+
+/*********************************************
+ * init_string_builder_functions: Initializes
+ *   the string builder type and functions.
+ **********************************************/
+void init_string_builder_functions(void *env)
+{
+    struct core_external_address_type builderType = {STRING_BUILDER_TYPE_NAME,
+                                                     _print_string_builder, _print_string_builder,
+                                                     _discard_string_builder, NULL, NULL};
+
+    core_allocate_environment_data(env, STRING_BUILDER_DATA_INDEX, sizeof(struct string_builder_data), _delete_string_builder_data);
+    get_string_builder_data(env)->address_type = core_install_ext_address_type(env, &builderType);
+
+    core_define_function(env, FUNC_NAME_SB_NEW, RT_UNKNOWN, PTR_FN broccoli_sb_new, "broccoli_sb_new", FUNC_CNSTR_SB_NEW);
+    core_define_function(env, FUNC_NAME_SB_APPEND, RT_UNKNOWN, PTR_FN broccoli_sb_append, "broccoli_sb_append", FUNC_CNSTR_SB_APPEND);
+    core_define_function(env, FUNC_NAME_SB_STRING, RT_UNKNOWN, PTR_FN broccoli_sb_string, "broccoli_sb_string", FUNC_CNSTR_SB_STRING);
+}
+
+/*************************************************
+ * _delete_string_builder_data: Frees the
+ *   builders the garbage collector did not
+ *   reclaim.
+ **************************************************/
+static void _delete_string_builder_data(void *env)
+{
+    struct string_builder *builder, *next;
+
+    for( builder = get_string_builder_data(env)->builders; builder != NULL; builder = next )
+    {
+        next = builder->next;
+        _free_string_builder(env, builder);
+    }
+}
+
+/*****************************************
+ * broccoli_sb_new: H/L access routine for
+ *   the sb-new function. Any arguments are
+ *   appended to the new builder.
+ ******************************************/
+void broccoli_sb_new(void *env, core_data_object_ptr ret)
+{
+    struct string_builder *builder;
+
+    core_set_pointer_type(ret, ATOM);
+    core_set_pointer_value(ret, get_false(env));
+
+    builder = core_mem_get_struct(env, string_builder);
+    builder->length = 0;
+    builder->capacity = STRING_BUILDER_MIN_SIZE;
+    builder->contents = (char *)core_mem_alloc_no_init(env, builder->capacity);
+    builder->contents[0] = EOS;
+
+    builder->prev = NULL;
+    builder->next = get_string_builder_data(env)->builders;
+
+    if( builder->next != NULL )
+    {
+        builder->next->prev = builder;
+    }
+
+    get_string_builder_data(env)->builders = builder;
+
+    core_set_pointer_type(ret, EXTERNAL_ADDRESS);
+    core_set_pointer_value(ret, store_external_address(env, builder, (unsigned)get_string_builder_data(env)->address_type));
+
+    _append_args(env, FUNC_NAME_SB_NEW, builder, 1);
+}
+
+/**********************************************
+ * broccoli_sb_append: H/L access routine for
+ *   the sb-append function. Returns the builder
+ *   so that calls can be chained.
+ ***********************************************/
+void broccoli_sb_append(void *env, core_data_object_ptr ret)
+{
+    struct string_builder *builder;
+    core_data_object arg;
+
+    core_set_pointer_type(ret, ATOM);
+    core_set_pointer_value(ret, get_false(env));
+
+    if((builder = _get_string_builder_arg(env, FUNC_NAME_SB_APPEND, &arg)) == NULL )
+    {
+        return;
+    }
+
+    if( _append_args(env, FUNC_NAME_SB_APPEND, builder, 2))
+    {
+        core_set_pointer_type(ret, EXTERNAL_ADDRESS);
+        core_set_pointer_value(ret, core_get_value(arg));
+    }
+}
+
+/**********************************************
+ * broccoli_sb_string: H/L access routine for
+ *   the sb-string function. This is the only
+ *   place the contents are interned.
+ ***********************************************/
+void broccoli_sb_string(void *env, core_data_object_ptr ret)
+{
+    struct string_builder *builder;
+    core_data_object arg;
+
+    core_set_pointer_type(ret, STRING);
+
+    if((builder = _get_string_builder_arg(env, FUNC_NAME_SB_STRING, &arg)) == NULL )
+    {
+        core_set_pointer_value(ret, store_atom(env, ""));
+        return;
+    }
+
+    core_set_pointer_value(ret, store_atom(env, builder->contents));
+}
+
+/***********************************************
+ * _get_string_builder_arg: Returns the
+ *   builder held by the first argument, or
+ *   NULL after an error if it is not a string
+ *   builder.
+ ************************************************/
+static struct string_builder *_get_string_builder_arg(void *env, char *functionName, core_data_object_ptr arg)
+{
+    struct external_address_hash_node *theAddress;
+
+    core_get_arg_at(env, 1, arg);
+
+    if( core_get_type(*arg) == EXTERNAL_ADDRESS )
+    {
+        theAddress = (struct external_address_hash_node *)core_get_value(*arg);
+
+        if( theAddress->type == get_string_builder_data(env)->address_type )
+        {
+            return((struct string_builder *)theAddress->address);
+        }
+    }
+
+    report_explicit_type_error(env, functionName, 1, "string builder");
+    core_set_eval_error(env, TRUE);
+    return(NULL);
+}
+
+/*************************************************
+ * _append_args: Appends the text of the arguments
+ *   from position start on. Strings and symbols
+ *   are copied as is and numbers are printed the
+ *   way str-cat prints them, without interning.
+ **************************************************/
+static BOOLEAN _append_args(void *env, char *functionName, struct string_builder *builder, int start)
+{
+    core_data_object arg;
+    char buffer[50];
+    int i, argCount;
+
+    argCount = core_get_arg_count(env);
+
+    for( i = start; i <= argCount; i++ )
+    {
+        core_get_arg_at(env, i, &arg);
+
+        switch( core_get_type(arg))
+        {
+        case STRING:
+#if OBJECT_SYSTEM
+        case INSTANCE_NAME:
+#endif
+        case ATOM:
+            _append_chars(env, builder, core_convert_data_to_string(arg),
+                          strlen(core_convert_data_to_string(arg)));
+            break;
+
+        case FLOAT:
+            sysdep_sprintf(buffer, "%.15g", to_double(core_get_value(arg)));
+
+            if( strpbrk(buffer, ".e") == NULL )
+            {
+                sysdep_strcat(buffer, ".0");
+            }
+
+            _append_chars(env, builder, buffer, strlen(buffer));
+            break;
+
+        case INTEGER:
+            sysdep_sprintf(buffer, "%lld", to_long(core_get_value(arg)));
+            _append_chars(env, builder, buffer, strlen(buffer));
+            break;
+
+        default:
+            report_explicit_type_error(env, functionName, i, "string, instance name, symbol, float, or integer");
+            core_set_eval_error(env, TRUE);
+            return(FALSE);
+        }
+    }
+
+    return(TRUE);
+}
+
+/*********************************************
+ * _append_chars: Appends length characters to
+ *   a builder, doubling its capacity as needed.
+ **********************************************/
+static void _append_chars(void *env, struct string_builder *builder, char *str, size_t length)
+{
+    size_t newCapacity;
+    char *newContents;
+
+    if( builder->length + length + 1 > builder->capacity )
+    {
+        newCapacity = builder->capacity * 2;
+
+        while( builder->length + length + 1 > newCapacity )
+        {
+            newCapacity *= 2;
+        }
+
+        newContents = (char *)core_mem_alloc_no_init(env, newCapacity);
+        memcpy(newContents, builder->contents, builder->length + 1);
+        core_mem_release(env, builder->contents, builder->capacity);
+        builder->contents = newContents;
+        builder->capacity = newCapacity;
+    }
+
+    memcpy(builder->contents + builder->length, str, length);
+    builder->length += length;
+    builder->contents[builder->length] = EOS;
+}
+
+/*********************************************
+ * _print_string_builder: Print routine for
+ *   the string builder external address type.
+ **********************************************/
+static void _print_string_builder(void *env, char *logicalName, void *value)
+{
+    struct string_builder *builder;
+    char buffer[30];
+
+    builder = (struct string_builder *)to_external_address(value);
+
+    print_router(env, logicalName, "<" STRING_BUILDER_TYPE_NAME "-");
+    sysdep_sprintf(buffer, "%ld", (long)builder->length);
+    print_router(env, logicalName, buffer);
+    print_router(env, logicalName, ">");
+}
+
+/*************************************************
+ * _discard_string_builder: Called by the garbage
+ *   collector once nothing refers to the builder.
+ **************************************************/
+static BOOLEAN _discard_string_builder(void *env, void *address)
+{
+    struct string_builder *builder = (struct string_builder *)address;
+
+    if( builder->prev == NULL )
+    {
+        get_string_builder_data(env)->builders = builder->next;
+    }
+    else
+    {
+        builder->prev->next = builder->next;
+    }
+
+    if( builder->next != NULL )
+    {
+        builder->next->prev = builder->prev;
+    }
+
+    _free_string_builder(env, builder);
+    return(TRUE);
+}
+
+/**********************************************
+ * _free_string_builder: Returns the memory
+ *   used by a builder and its contents.
+ ***********************************************/
+static void _free_string_builder(void *env, struct string_builder *builder)
+{
+    core_mem_release(env, builder->contents, builder->capacity);
+    core_mem_return_struct(env, string_builder, builder);
+}
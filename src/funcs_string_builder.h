@@ -0,0 +1,67 @@
+/* Purpose: Mutable string builders for assembling large
+ *   strings piece by piece without interning every
+ *   intermediate result.                                  */
+
+#ifndef __FUNCS_STRING_BUILDER_H__
+#define __FUNCS_STRING_BUILDER_H__
+
+#ifndef __CORE_EVALUATION_H__
+#include "core_evaluation.h"
+#endif
+
+#define STRING_BUILDER_DATA_INDEX 11
+#define STRING_BUILDER_TYPE_NAME  "StringBuilder"
+#define STRING_BUILDER_MIN_SIZE   64
+
+/*==================================================
+ * A builder is handed to Lisp code as an external
+ * address. Its contents are plain memory that is
+ * grown by doubling, and only sb-string turns them
+ * into a symbol table entry. Live builders are
+ * chained so that teardown can free the ones the
+ * garbage collector never got to.
+ *==================================================*/
+struct string_builder
+{
+    char *                 contents;
+    size_t                 length;
+    size_t                 capacity;
+    struct string_builder *prev;
+    struct string_builder *next;
+};
+
+struct string_builder_data
+{
+    int                    address_type;
+    struct string_builder *builders;
+};
+
+#define get_string_builder_data(env) ((struct string_builder_data *)core_get_environment_data(env, STRING_BUILDER_DATA_INDEX))
+
+#ifdef LOCALE
+#undef LOCALE
+#endif
+
+#ifdef __FUNCS_STRING_BUILDER_SOURCE__
+#define LOCALE
+#else
+#define LOCALE extern
+#endif
+
+LOCALE void init_string_builder_functions(void *);
+LOCALE void broccoli_sb_new(void *, core_data_object_ptr);
+LOCALE void broccoli_sb_append(void *, core_data_object_ptr);
+LOCALE void broccoli_sb_string(void *, core_data_object_ptr);
+
+/***
+ * Function names and constraints
+ **/
+#define FUNC_NAME_SB_NEW            "sb-new"
+#define FUNC_NAME_SB_APPEND         "sb-append"
+#define FUNC_NAME_SB_STRING         "sb-string"
+
+#define FUNC_CNSTR_SB_NEW           "0*"
+#define FUNC_CNSTR_SB_APPEND        "1*"
+#define FUNC_CNSTR_SB_STRING        "11"
+
+#endif
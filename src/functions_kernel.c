@@ -16,13 +16,20 @@
 
 #include "core_constructs.h"
 #include "core_environment.h"
+#include "core_functions.h"
+#include "core_memory.h"
+#include "core_utilities.h"
 #include "funcs_function.h"
 #include "core_functions_util.h"
 #include "funcs_profiling.h"
+#include "funcs_sampling.h"
 #include "router.h"
 #include "core_gc.h"
 #include "core_watch.h"
 #include "funcs_flow_control.h"
+#if BYTECODE_FUNCTIONS
+#include "core_bytecode.h"
+#endif
 
 #define __FUNCTIONS_KERNEL_SOURCE__
 #include "functions_kernel.h"
@@ -42,6 +49,14 @@
  ***************************************** */
 
 static void _error_unknown_function(void *);
+static void _execute_body(void *, FUNCTION_DEFINITION *, core_data_object *);
+
+static void _install_values(void *, core_data_object *, int);
+static void _uninstall_values(void *, core_data_object *, int);
+static void _end_tail_calls(void *, struct function_tail_call *, struct function_tail_call *);
+#if !BYTECODE_FUNCTIONS
+static int  _eval_tail_action(void *, core_expression_object *, core_data_object *);
+#endif
 
 #if DEBUGGING_FUNCTIONS
 static void WatchDeffunction(void *, char *);
@@ -63,15 +78,17 @@ static void WatchDeffunction(void *, char *);
  *  SIDE EFFECTS : Deffunction executed and result
  *              stored in data object buffer
  *  NOTES        : Used in core_eval_expression(env,)
+ *              Deffunctions called in tail position
+ *              by the body are run by the loop here,
+ *              reusing this frame, instead of being
+ *              nested on the C stack
  ****************************************************/
 void function_execute(void *env, FUNCTION_DEFINITION *dptr, core_expression_object *args, core_data_object *result)
 {
     int oldce;
     FUNCTION_DEFINITION *previouslyExecutingDeffunction;
-
-#if PROFILING_FUNCTIONS
-    struct profileFrameInfo profileFrame;
-#endif
+    struct function_tail_call tailCall, *previousTailCall;
+    BOOLEAN tailEntered = FALSE;
 
     result->type = ATOM;
     result->value = get_false(env);
@@ -85,22 +102,169 @@ void function_execute(void *env, FUNCTION_DEFINITION *dptr, core_expression_obje
     oldce = core_is_construct_executing(env);
     core_set_construct_executing(env, TRUE);
     previouslyExecutingDeffunction = get_function_data(env)->executing_function;
-    get_function_data(env)->executing_function = dptr;
     core_get_evaluation_data(env)->eval_depth++;
-    dptr->executing++;
-    core_push_function_args(env, args, core_count_args(args), get_function_name(env, (void *)dptr),
-                            FUNC_NAME_CREATE_FUNC, _error_unknown_function);
 
-    if( core_get_evaluation_data(env)->eval_error )
+    tailCall.function = NULL;
+    tailCall.argc = 0;
+    tailCall.size = 0;
+    tailCall.values = NULL;
+    tailCall.args = NULL;
+    previousTailCall = get_function_data(env)->tail_call;
+    get_function_data(env)->tail_call = &tailCall;
+
+    do
     {
+        get_function_data(env)->executing_function = dptr;
+        dptr->executing++;
+        core_push_function_args(env, args, core_count_args(args), get_function_name(env, (void *)dptr),
+                                FUNC_NAME_CREATE_FUNC, _error_unknown_function);
+
+        if( core_get_evaluation_data(env)->eval_error )
+        {
+            dptr->executing--;
+
+            if( tailEntered )
+            {
+                _uninstall_values(env, tailCall.values, tailCall.argc);
+            }
+
+            _end_tail_calls(env, &tailCall, previousTailCall);
+            get_function_data(env)->executing_function = previouslyExecutingDeffunction;
+            core_get_evaluation_data(env)->eval_depth--;
+            core_gc_periodic_cleanup(env, FALSE, TRUE);
+            core_set_construct_executing(env, oldce);
+            return;
+        }
+
+        _execute_body(env, dptr, result);
+        get_flow_control_data(env)->return_flag = FALSE;
         dptr->executing--;
-        get_function_data(env)->executing_function = previouslyExecutingDeffunction;
-        core_get_evaluation_data(env)->eval_depth--;
-        core_gc_periodic_cleanup(env, FALSE, TRUE);
-        core_set_construct_executing(env, oldce);
-        return;
+
+        /*=====================================================
+         * The arguments of a tail call were created at this
+         * depth, so they are installed while the garbage of
+         * the finished call is cleaned up as if it returned.
+         *=====================================================*/
+        if( tailEntered )
+        {
+            _uninstall_values(env, core_get_function_primitive_data(env)->arguments,
+                              core_get_function_primitive_data(env)->arguments_sz);
+        }
+
+        tailEntered = (tailCall.function != NULL);
+
+        if( tailEntered )
+        {
+            _install_values(env, tailCall.values, tailCall.argc);
+        }
+
+        core_pop_function_args(env);
+
+        if( tailEntered )
+        {
+            core_get_evaluation_data(env)->eval_depth--;
+            core_gc_periodic_cleanup(env, FALSE, TRUE);
+            core_get_evaluation_data(env)->eval_depth++;
+
+            dptr = tailCall.function;
+            args = (tailCall.argc != 0) ? tailCall.args : NULL;
+            tailCall.function = NULL;
+
+            if( core_get_evaluation_data(env)->halt )
+            {
+                _uninstall_values(env, tailCall.values, tailCall.argc);
+                tailEntered = FALSE;
+            }
+        }
+
+    }
+    while( tailEntered );
+
+    _end_tail_calls(env, &tailCall, previousTailCall);
+    get_function_data(env)->executing_function = previouslyExecutingDeffunction;
+    core_get_evaluation_data(env)->eval_depth--;
+    core_pass_return_value(env, result);
+    core_gc_periodic_cleanup(env, FALSE, TRUE);
+    core_set_construct_executing(env, oldce);
+}
+
+/*****************************************************
+ *  NAME         : function_prepare_tail_call
+ *  DESCRIPTION  : Called by a deffunction body for
+ *              a deffunction call in tail position
+ *  INPUTS       : 1) The deffunction to call
+ *              2) The number of arguments
+ *  RETURNS      : The buffer the argument values
+ *              are to be copied to, or NULL if
+ *              the call must be made normally
+ *  SIDE EFFECTS : The call is left pending for the
+ *              innermost function_execute
+ *  NOTES        : None
+ *****************************************************/
+core_data_object *function_prepare_tail_call(void *env, FUNCTION_DEFINITION *dptr, int argc)
+{
+    struct function_tail_call *tailCall = get_function_data(env)->tail_call;
+    int i;
+
+    if( tailCall == NULL )
+    {
+        return(NULL);
     }
 
+    if((argc > tailCall->size) || (tailCall->values == NULL))
+    {
+        if( tailCall->values != NULL )
+        {
+            core_mem_release(env, (void *)tailCall->values,
+                             (sizeof(core_data_object) + sizeof(core_expression_object)) * tailCall->size);
+        }
+
+        tailCall->size = (argc > 0) ? argc : 1;
+        tailCall->values = (core_data_object *)
+                           core_mem_alloc_no_init(env, (sizeof(core_data_object) + sizeof(core_expression_object)) * tailCall->size);
+        tailCall->args = (core_expression_object *)(tailCall->values + tailCall->size);
+
+        for( i = 0 ; i < tailCall->size ; i++ )
+        {
+            tailCall->args[i].type = DATA_OBJECT_VALUE;
+            tailCall->args[i].value = (void *)&tailCall->values[i];
+            tailCall->args[i].args = NULL;
+        }
+    }
+
+    for( i = 0 ; i < argc ; i++ )
+    {
+        tailCall->args[i].next_arg = ((i + 1) < argc) ? &tailCall->args[i + 1] : NULL;
+    }
+
+    tailCall->function = dptr;
+    tailCall->argc = argc;
+
+    return(tailCall->values);
+}
+
+/* =========================================
+ *****************************************
+ *       INTERNALLY VISIBLE FUNCTIONS
+ *  =========================================
+ ***************************************** */
+
+/****************************************************
+ *  NAME         : _execute_body
+ *  DESCRIPTION  : Runs the actions of a deffunction
+ *              whose arguments have been pushed
+ *  INPUTS       : 1) The deffunction
+ *              2) Data object buffer to hold result
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Actions executed
+ *  NOTES        : None
+ ****************************************************/
+static void _execute_body(void *env, FUNCTION_DEFINITION *dptr, core_data_object *result)
+{
+#if PROFILING_FUNCTIONS
+    struct profileFrameInfo profileFrame;
+#endif
+
 #if DEBUGGING_FUNCTIONS
 
     if( dptr->trace )
@@ -110,20 +274,44 @@ void function_execute(void *env, FUNCTION_DEFINITION *dptr, core_expression_obje
 
 #endif
 
+#if SAMPLING_FUNCTIONS
+    sampling_push_frame(env, dptr);
+#endif
+
 #if PROFILING_FUNCTIONS
     StartProfile(env, &profileFrame,
                  &dptr->header.ext_data,
                  ProfileFunctionData(env)->ProfileConstructs);
 #endif
 
-    core_eval_function_actions(env, dptr->header.my_module->module_def,
-                               dptr->code, dptr->local_variable_count,
-                               result, _error_unknown_function);
+#if BYTECODE_FUNCTIONS
+
+    /*=================================================
+     * Bodies are compiled on their first call so that
+     * deffunctions which are never run cost nothing.
+     *=================================================*/
+    if((dptr->bytecode == NULL) && (dptr->code != NULL))
+    {
+        dptr->bytecode = core_bytecode_compile(env, dptr->code);
+    }
+
+    core_eval_function_bytecode(env, dptr->header.my_module->module_def,
+                                dptr->code, dptr->bytecode, dptr->local_variable_count,
+                                result, _error_unknown_function);
+#else
+    core_eval_function_walker(env, dptr->header.my_module->module_def,
+                              dptr->code, dptr->local_variable_count,
+                              result, _error_unknown_function, _eval_tail_action);
+#endif
 
 #if PROFILING_FUNCTIONS
     EndProfile(env, &profileFrame);
 #endif
 
+#if SAMPLING_FUNCTIONS
+    sampling_pop_frame(env);
+#endif
+
 #if DEBUGGING_FUNCTIONS
 
     if( dptr->trace )
@@ -132,22 +320,200 @@ void function_execute(void *env, FUNCTION_DEFINITION *dptr, core_expression_obje
     }
 
 #endif
-    get_flow_control_data(env)->return_flag = FALSE;
+}
 
-    dptr->executing--;
-    core_pop_function_args(env);
-    get_function_data(env)->executing_function = previouslyExecutingDeffunction;
-    core_get_evaluation_data(env)->eval_depth--;
-    core_pass_return_value(env, result);
-    core_gc_periodic_cleanup(env, FALSE, TRUE);
-    core_set_construct_executing(env, oldce);
+#if !BYTECODE_FUNCTIONS
+
+/****************************************************
+ *  NAME         : _eval_tail_action
+ *  DESCRIPTION  : Evaluates the body of a deffunction
+ *              when it is walked. The tail positions
+ *              of progn and if are followed, and a
+ *              deffunction call found there has its
+ *              arguments evaluated and is left for
+ *              function_execute to make.
+ *  INPUTS       : 1) The body expression
+ *              2) Data object buffer to hold result
+ *  RETURNS      : TRUE if an error occurred,
+ *              FALSE otherwise
+ *  SIDE EFFECTS : Expression evaluated
+ *  NOTES        : Mirrors the lowering done by the
+ *              bytecode compiler
+ ****************************************************/
+static int _eval_tail_action(void *env, core_expression_object *expr, core_data_object *result)
+{
+    struct core_function_definition *prognFunction, *ifFunction;
+    core_expression_object *arg;
+    core_data_object *values;
+    int argc, i;
+
+    prognFunction = core_lookup_function(env, FUNC_NAME_PROGN);
+    ifFunction = core_lookup_function(env, "if");
+
+    while((expr != NULL) && (expr->type == FCALL))
+    {
+        if((expr->value == (void *)prognFunction) && (expr->args != NULL))
+        {
+            for( arg = expr->args ; arg->next_arg != NULL ; arg = arg->next_arg )
+            {
+                core_eval_expression(env, arg, result);
+
+                if( core_get_evaluation_data(env)->halt ||
+                    get_flow_control_data(env)->break_flag || get_flow_control_data(env)->return_flag )
+                {
+                    return(core_get_evaluation_data(env)->eval_error);
+                }
+            }
+
+            expr = arg;
+        }
+        else if((expr->value == (void *)ifFunction) && (expr->args != NULL) &&
+                (expr->args->next_arg != NULL) &&
+                ((expr->args->next_arg->next_arg == NULL) ||
+                 (expr->args->next_arg->next_arg->next_arg == NULL)))
+        {
+            core_eval_expression(env, expr->args, result);
+
+            if( get_flow_control_data(env)->break_flag || get_flow_control_data(env)->return_flag )
+            {
+                result->type = ATOM;
+                result->value = get_false(env);
+                return(core_get_evaluation_data(env)->eval_error);
+            }
+
+            if((result->type != ATOM) || (result->value != get_false(env)))
+            {
+                expr = expr->args->next_arg;
+            }
+            else if( expr->args->next_arg->next_arg != NULL )
+            {
+                expr = expr->args->next_arg->next_arg;
+            }
+            else
+            {
+                return(core_get_evaluation_data(env)->eval_error);
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if((expr == NULL) || (expr->type != PCALL) ||
+       core_get_evaluation_data(env)->halt || core_get_evaluation_data(env)->eval_error )
+    {
+        return(core_eval_expression(env, expr, result));
+    }
+
+    argc = core_count_args(expr->args);
+
+    if((values = function_prepare_tail_call(env, (FUNCTION_DEFINITION *)expr->value, argc)) == NULL )
+    {
+        return(core_eval_expression(env, expr, result));
+    }
+
+    for( arg = expr->args, i = 0 ; arg != NULL ; arg = arg->next_arg, i++ )
+    {
+        if((core_eval_expression(env, arg, &values[i]) == TRUE) ? TRUE :
+           (values[i].type == RVOID))
+        {
+            if( values[i].type == RVOID )
+            {
+                error_print_id(env, "FLOW", 2, FALSE);
+                print_router(env, WERROR, "Functions without a return value are illegal as ");
+                print_router(env, WERROR, FUNC_NAME_CREATE_FUNC);
+                print_router(env, WERROR, " arguments.\n");
+                core_set_eval_error(env, TRUE);
+            }
+
+            error_print_id(env, "FLOW", 6, FALSE);
+            print_router(env, WERROR, "This error occurred while evaluating arguments for the ");
+            print_router(env, WERROR, FUNC_NAME_CREATE_FUNC);
+            print_router(env, WERROR, " ");
+            print_router(env, WERROR, get_function_name(env, expr->value));
+            print_router(env, WERROR, ".\n");
+            get_function_data(env)->tail_call->function = NULL;
+            result->type = ATOM;
+            result->value = get_false(env);
+            return(TRUE);
+        }
+    }
+
+    if( core_get_evaluation_data(env)->halt )
+    {
+        get_function_data(env)->tail_call->function = NULL;
+    }
+
+    result->type = ATOM;
+    result->value = get_false(env);
+    return(core_get_evaluation_data(env)->eval_error);
+}
+
+#endif
+
+/****************************************************
+ *  NAME         : _install_values
+ *  DESCRIPTION  : Keeps the argument values of a
+ *              tail call from being garbage
+ *              collected
+ *  INPUTS       : 1) The values
+ *              2) The number of values
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Reference counts incremented
+ *  NOTES        : None
+ ****************************************************/
+static void _install_values(void *env, core_data_object *values, int count)
+{
+    int i;
+
+    for( i = 0 ; i < count ; i++ )
+    {
+        core_value_increment(env, &values[i]);
+    }
+}
+
+/****************************************************
+ *  NAME         : _uninstall_values
+ *  DESCRIPTION  : Undoes _install_values
+ *  INPUTS       : 1) The values
+ *              2) The number of values
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Reference counts decremented
+ *  NOTES        : None
+ ****************************************************/
+static void _uninstall_values(void *env, core_data_object *values, int count)
+{
+    int i;
+
+    for( i = 0 ; i < count ; i++ )
+    {
+        core_value_decrement(env, &values[i]);
+    }
+}
+
+/****************************************************
+ *  NAME         : _end_tail_calls
+ *  DESCRIPTION  : Releases the tail call buffer of a
+ *              function_execute and restores the
+ *              one of the enclosing call
+ *  INPUTS       : 1) The tail call buffer
+ *              2) The enclosing buffer
+ *  RETURNS      : Nothing useful
+ *  SIDE EFFECTS : Buffer memory released
+ *  NOTES        : None
+ ****************************************************/
+static void _end_tail_calls(void *env, struct function_tail_call *tailCall, struct function_tail_call *previousTailCall)
+{
+    if( tailCall->values != NULL )
+    {
+        core_mem_release(env, (void *)tailCall->values,
+                         (sizeof(core_data_object) + sizeof(core_expression_object)) * tailCall->size);
+    }
+
+    get_function_data(env)->tail_call = previousTailCall;
 }
 
-/* =========================================
- *****************************************
- *       INTERNALLY VISIBLE FUNCTIONS
- *  =========================================
- ***************************************** */
 
 /*******************************************************
  *  NAME         : UnboundDeffunctionErr
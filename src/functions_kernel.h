@@ -20,5 +20,6 @@
 #endif
 
 LOCALE void function_execute(void *, FUNCTION_DEFINITION *, core_expression_object *, core_data_object *);
+LOCALE core_data_object *function_prepare_tail_call(void *, FUNCTION_DEFINITION *, int);
 
 #endif
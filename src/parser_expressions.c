@@ -35,6 +35,13 @@
 
 static BOOLEAN _replace_list_args(void *, struct core_expression *, struct core_expression *, void *, void *);
 static int     _validate_expression_against_restrictions(void *, struct core_expression *, char *, char *);
+static void    _optimize_list(void *, struct core_expression *);
+static void    _splice_progns(void *, struct core_expression *);
+static void    _flatten_left_nested_call(void *, struct core_expression *);
+static void    _fold_constant_call(void *, struct core_expression *);
+static BOOLEAN _is_constant_expression(struct core_expression *);
+static int     _find_optimizer_router(void *, char *);
+static int     _print_optimizer_router(void *, char *, char *);
 
 /******************************************************
  * parse_virgin_function: Parses a function. Assumes that the
@@ -940,3 +947,233 @@ struct core_expression *strip_frivolous_progn(void *env, struct core_expression
 
     return(expr);
 }
+
+/********************************************************
+ * init_expression_optimizer: Adds the router that keeps
+ *   the errors of calls which cannot be folded quiet.
+ *   It is only active while optimize_expression runs.
+ *********************************************************/
+void init_expression_optimizer(void *env)
+{
+    add_router(env, OPTIMIZER_ROUTER_NAME, 1000, _find_optimizer_router, _print_optimizer_router, NULL, NULL, NULL);
+    deactivate_router(env, OPTIMIZER_ROUTER_NAME);
+}
+
+/*********************************************************
+ * optimize_expression: Simplifies the parsed actions of a
+ *   procedure body before they are packed. Nested progns
+ *   are spliced into the enclosing progn, left nested
+ *   calls to + and * are merged into a single call, and
+ *   calls to pure functions with constant arguments are
+ *   replaced by their value. The tree is changed in place.
+ **********************************************************/
+void optimize_expression(void *env, struct core_expression *expr)
+{
+    if( expr == NULL )
+    {
+        return;
+    }
+
+    activate_router(env, OPTIMIZER_ROUTER_NAME);
+    _optimize_list(env, expr);
+    deactivate_router(env, OPTIMIZER_ROUTER_NAME);
+}
+
+/*********************************************************
+ * _optimize_list: Optimizes a list of expressions bottom
+ *   up, so that folded arguments can fold their caller.
+ **********************************************************/
+static void _optimize_list(void *env, struct core_expression *expr)
+{
+    for( ; expr != NULL ; expr = expr->next_arg )
+    {
+        _optimize_list(env, expr->args);
+
+        if( expr->type != FCALL )
+        {
+            continue;
+        }
+
+        _splice_progns(env, expr);
+        _flatten_left_nested_call(env, expr);
+
+        if(((struct core_function_definition *)expr->value)->pure )
+        {
+            _fold_constant_call(env, expr);
+        }
+    }
+}
+
+/*********************************************************
+ * _splice_progns: Replaces a progn with actions that
+ *   is an action of a progn by its own actions.
+ **********************************************************/
+static void _splice_progns(void *env, struct core_expression *expr)
+{
+    struct core_expression *action, *last, *inner;
+
+    if( core_get_expression_function_ptr(expr) != VOID_FN broccoli_progn )
+    {
+        return;
+    }
+
+    for( action = expr->args, last = NULL ; action != NULL ; )
+    {
+        if((action->type != FCALL) || (action->args == NULL) ||
+           (core_get_expression_function_ptr(action) != VOID_FN broccoli_progn))
+        {
+            last = action;
+            action = action->next_arg;
+            continue;
+        }
+
+        for( inner = action->args ; inner->next_arg != NULL ; inner = inner->next_arg )
+        {
+            ;
+        }
+
+        inner->next_arg = action->next_arg;
+
+        if( last == NULL )
+        {
+            expr->args = action->args;
+        }
+        else
+        {
+            last->next_arg = action->args;
+        }
+
+        action->args = NULL;
+        action->next_arg = NULL;
+        core_return_expression(env, action);
+
+        last = inner;
+        action = inner->next_arg;
+    }
+}
+
+/*********************************************************
+ * _flatten_left_nested_call: (+ (+ a b) c) becomes
+ *   (+ a b c). The arguments are still evaluated and
+ *   accumulated left to right, so integer and float
+ *   results are the same. Only + and * are flattened.
+ **********************************************************/
+static void _flatten_left_nested_call(void *env, struct core_expression *expr)
+{
+    struct core_expression *inner, *last;
+
+    if((expr->value != core_get_expression_data(env)->fn_add) &&
+       (expr->value != core_get_expression_data(env)->fn_multiply))
+    {
+        return;
+    }
+
+    while(((inner = expr->args) != NULL) &&
+          (inner->type == FCALL) && (inner->value == expr->value) &&
+          (inner->args != NULL) && (inner->args->next_arg != NULL))
+    {
+        for( last = inner->args ; last->next_arg != NULL ; last = last->next_arg )
+        {
+            ;
+        }
+
+        last->next_arg = inner->next_arg;
+        expr->args = inner->args;
+        inner->args = NULL;
+        inner->next_arg = NULL;
+        core_return_expression(env, inner);
+    }
+}
+
+/*********************************************************
+ * _fold_constant_call: Evaluates a call to a pure
+ *   function whose arguments are all constants and turns
+ *   the call into its value. A call that fails is left as it is
+ *   so that the error is raised when it is executed.
+ **********************************************************/
+static void _fold_constant_call(void *env, struct core_expression *expr)
+{
+    struct core_expression *arg;
+    core_data_object result;
+    int oldError, oldHalt;
+
+    for( arg = expr->args ; arg != NULL ; arg = arg->next_arg )
+    {
+        if( !_is_constant_expression(arg))
+        {
+            return;
+        }
+    }
+
+    oldError = core_get_evaluation_data(env)->eval_error;
+    oldHalt = core_get_evaluation_data(env)->halt;
+    core_get_evaluation_data(env)->eval_error = FALSE;
+    core_get_evaluation_data(env)->halt = FALSE;
+
+    core_eval_expression(env, expr, &result);
+
+    if( core_get_evaluation_data(env)->eval_error || core_get_evaluation_data(env)->halt )
+    {
+        core_get_evaluation_data(env)->eval_error = oldError;
+        core_get_evaluation_data(env)->halt = oldHalt;
+        return;
+    }
+
+    core_get_evaluation_data(env)->eval_error = oldError;
+    core_get_evaluation_data(env)->halt = oldHalt;
+
+    switch( result.type )
+    {
+    case ATOM:
+    case STRING:
+    case INTEGER:
+    case FLOAT:
+        core_return_expression(env, expr->args);
+        expr->args = NULL;
+        expr->type = result.type;
+        expr->value = result.value;
+        break;
+    }
+}
+
+/*********************************************************
+ * _is_constant_expression: Returns TRUE for the
+ *   literals a call can be folded into.
+ **********************************************************/
+static BOOLEAN _is_constant_expression(struct core_expression *expr)
+{
+    switch( expr->type )
+    {
+    case ATOM:
+    case STRING:
+    case INTEGER:
+    case FLOAT:
+        return(TRUE);
+    }
+
+    return(FALSE);
+}
+
+/*********************************************************
+ * _find_optimizer_router: Claims the error and warning
+ *   output while the optimizer router is active.
+ **********************************************************/
+static int _find_optimizer_router(void *env, char *logicalName)
+{
+    if((strcmp(logicalName, WERROR) == 0) ||
+       (strcmp(logicalName, WWARNING) == 0))
+    {
+        return(TRUE);
+    }
+
+    return(FALSE);
+}
+
+/*********************************************************
+ * _print_optimizer_router: Discards the output claimed by
+ *   the optimizer router.
+ **********************************************************/
+static int _print_optimizer_router(void *env, char *logicalName, char *str)
+{
+    return(1);
+}
@@ -39,6 +39,10 @@ LOCALE struct core_expression                 * parse_atom_or_expression(void *,
 LOCALE core_expression_object                 * parse_constants(void *, char *, int *);
 LOCALE struct core_expression                 * group_actions(void *, char *, struct token *, int, char *, int);
 LOCALE struct core_expression                 * strip_frivolous_progn(void *, struct core_expression *);
+LOCALE void                                     init_expression_optimizer(void *);
+LOCALE void                                     optimize_expression(void *, struct core_expression *);
+
+#define OPTIMIZER_ROUTER_NAME               "optimizer"
 
 #define ERROR_TAG_EXPRESSION_PARSER         "Parse Error "
 #define ERROR_MSG_INVALID_FUNC_NAME         "Function names must be symbols"
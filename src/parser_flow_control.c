@@ -18,17 +18,18 @@
 #include "router.h"
 #include "core_scanner.h"
 #include "core_gc.h"
+#include "funcs_flow_control.h"
 
 #include "parser_flow_control.h"
 
 #define PRCDRPSR_DATA 12
 
-struct flow_control_data
+struct parser_flow_control_data
 {
     struct binding *binding_names;
 };
 
-#define get_flow_control_data(env) ((struct flow_control_data *)core_get_environment_data(env, PRCDRPSR_DATA))
+#define get_parser_flow_control_data(env) ((struct parser_flow_control_data *)core_get_environment_data(env, PRCDRPSR_DATA))
 
 /**************************************
  * LOCAL FUNCTION PROTOTYPES
@@ -45,7 +46,7 @@ static void                     _replace_loop_count_variables(void *, ATOM_HN *,
  *******************************************/
 void init_flow_control_parsers(void *env)
 {
-    core_allocate_environment_data(env, PRCDRPSR_DATA, sizeof(struct flow_control_data), _delete_flow_control_data);
+    core_allocate_environment_data(env, PRCDRPSR_DATA, sizeof(struct parser_flow_control_data), _delete_flow_control_data);
 
     core_add_function_parser(env, FUNC_NAME_ASSIGNMENT, _parse_binding);
     core_add_function_parser(env, "if", _parse_if);
@@ -59,11 +60,11 @@ static void _delete_flow_control_data(void *env)
 {
     struct binding *temp_bind;
 
-    while( get_flow_control_data(env)->binding_names != NULL )
+    while( get_parser_flow_control_data(env)->binding_names != NULL )
     {
-        temp_bind = get_flow_control_data(env)->binding_names->next;
-        core_mem_return_struct(env, binding, get_flow_control_data(env)->binding_names);
-        get_flow_control_data(env)->binding_names = temp_bind;
+        temp_bind = get_parser_flow_control_data(env)->binding_names->next;
+        core_mem_return_struct(env, binding, get_parser_flow_control_data(env)->binding_names);
+        get_parser_flow_control_data(env)->binding_names = temp_bind;
     }
 }
 
@@ -72,7 +73,7 @@ static void _delete_flow_control_data(void *env)
  ********************************************************/
 struct binding *get_parsed_bindings(void *env)
 {
-    return(get_flow_control_data(env)->binding_names);
+    return(get_parser_flow_control_data(env)->binding_names);
 }
 
 /*******************************************************
@@ -80,7 +81,7 @@ struct binding *get_parsed_bindings(void *env)
  ********************************************************/
 void set_parsed_bindings(void *env, struct binding *newValue)
 {
-    get_flow_control_data(env)->binding_names = newValue;
+    get_parser_flow_control_data(env)->binding_names = newValue;
 }
 
 /*******************************************************
@@ -90,12 +91,12 @@ void clear_parsed_bindings(void *env)
 {
     struct binding *temp_bind;
 
-    while( get_flow_control_data(env)->binding_names != NULL )
+    while( get_parser_flow_control_data(env)->binding_names != NULL )
     {
-        temp_bind = get_flow_control_data(env)->binding_names->next;
-        remove_constraint(env, get_flow_control_data(env)->binding_names->constraints);
-        core_mem_return_struct(env, binding, get_flow_control_data(env)->binding_names);
-        get_flow_control_data(env)->binding_names = temp_bind;
+        temp_bind = get_parser_flow_control_data(env)->binding_names->next;
+        remove_constraint(env, get_parser_flow_control_data(env)->binding_names->constraints);
+        core_mem_return_struct(env, binding, get_parser_flow_control_data(env)->binding_names);
+        get_parser_flow_control_data(env)->binding_names = temp_bind;
     }
 }
 
@@ -104,7 +105,7 @@ void clear_parsed_bindings(void *env)
  ********************************************************/
 BOOLEAN are_bindings_empty(void *env)
 {
-    if( get_flow_control_data(env)->binding_names != NULL )
+    if( get_parser_flow_control_data(env)->binding_names != NULL )
     {
         return(FALSE);
     }
@@ -150,7 +151,7 @@ static struct core_expression *_parse_binding(void *env, struct core_expression
     top->args = core_generate_constant(env, ATOM, theToken.value);
     variableName = (ATOM_HN *)theToken.value;
 
-    texp = core_mem_get_struct(env, core_expression);
+    texp = core_get_expression_node(env);
     texp->args = texp->next_arg = NULL;
 
     if( collect_args(env, texp, infile) == NULL )
@@ -160,7 +161,7 @@ static struct core_expression *_parse_binding(void *env, struct core_expression
     }
 
     top->args->next_arg = texp->args;
-    core_mem_return_struct(env, core_expression, texp);
+    core_return_expression_node(env, texp);
 
     if( top->args->next_arg != NULL )
     {
@@ -180,7 +181,7 @@ int find_parsed_binding(void *env, ATOM_HN *name_sought)
     struct binding *var_ptr;
     int theIndex = 1;
 
-    var_ptr = get_flow_control_data(env)->binding_names;
+    var_ptr = get_parser_flow_control_data(env)->binding_names;
 
     while( var_ptr != NULL )
     {
@@ -196,6 +197,54 @@ int find_parsed_binding(void *env, ATOM_HN *name_sought)
     return(0);
 }
 
+/*******************************************************
+ * resolve_parsed_bindings: Replaces the variable
+ *   references and bind calls of a parsed top level
+ *   command or eval string with expressions that
+ *   address the frame slots of the variables directly.
+ *   Done once the whole expression is parsed, since
+ *   parsers such as the one for for rewrite variable
+ *   references of their bodies afterwards. Deffunction
+ *   bodies do not need this: their variables are
+ *   already frame indexes (FUNCTION_VAR).
+ ********************************************************/
+void resolve_parsed_bindings(void *env, struct core_expression *actions)
+{
+    struct core_function_definition *bindFunction;
+    struct core_expression *valueArgs;
+    int slot;
+
+    bindFunction = core_lookup_function(env, FUNC_NAME_ASSIGNMENT);
+
+    while( actions != NULL )
+    {
+        if((actions->type == SCALAR_VARIABLE) || (actions->type == LIST_VARIABLE))
+        {
+            slot = find_binding_slot(env, (ATOM_HN *)actions->value, TRUE);
+            actions->args = core_generate_constant(env, ATOM, actions->value);
+            actions->type = BINDING_SLOT_META;
+            actions->value = store_bitmap(env, (void *)&slot, (int)sizeof(int));
+        }
+        else if( actions->args != NULL )
+        {
+            resolve_parsed_bindings(env, actions->args);
+
+            if((actions->type == FCALL) && (actions->value == (void *)bindFunction) &&
+               (actions->args->type == ATOM))
+            {
+                slot = find_binding_slot(env, (ATOM_HN *)actions->args->value, TRUE);
+                valueArgs = actions->args->next_arg;
+                core_return_expression_node(env, actions->args);
+                actions->type = BINDING_SLOT;
+                actions->value = store_bitmap(env, (void *)&slot, (int)sizeof(int));
+                actions->args = valueArgs;
+            }
+        }
+
+        actions = actions->next_arg;
+    }
+}
+
 /*******************************************************
  * get_binding_count_in_current_context: Counts the number of variables
  *   names that have been bound using the bind function
@@ -206,7 +255,7 @@ int get_binding_count_in_current_context(void *env)
     struct binding *theVariable;
     int theIndex = 0;
 
-    theVariable = get_flow_control_data(env)->binding_names;
+    theVariable = get_parser_flow_control_data(env)->binding_names;
 
     while( theVariable != NULL )
     {
@@ -236,7 +285,7 @@ static int _add_binding_name(void *env, ATOM_HN *variableName, CONSTRAINT_META *
      *=========================================================*/
 
     lastBind = NULL;
-    currentBind = get_flow_control_data(env)->binding_names;
+    currentBind = get_parser_flow_control_data(env)->binding_names;
 
     while( currentBind != NULL )
     {
@@ -270,7 +319,7 @@ static int _add_binding_name(void *env, ATOM_HN *variableName, CONSTRAINT_META *
 
     if( lastBind == NULL )
     {
-        get_flow_control_data(env)->binding_names = currentBind;
+        get_parser_flow_control_data(env)->binding_names = currentBind;
     }
     else
     {
@@ -288,7 +337,7 @@ void remove_binding(void *env, struct atom_hash_node *bname)
     struct binding *prv, *tmp;
 
     prv = NULL;
-    tmp = get_flow_control_data(env)->binding_names;
+    tmp = get_parser_flow_control_data(env)->binding_names;
 
     while((tmp != NULL) ? (tmp->name != bname) : FALSE )
     {
@@ -300,7 +349,7 @@ void remove_binding(void *env, struct atom_hash_node *bname)
     {
         if( prv == NULL )
         {
-            get_flow_control_data(env)->binding_names = tmp->next;
+            get_parser_flow_control_data(env)->binding_names = tmp->next;
         }
         else
         {
@@ -28,6 +28,7 @@ LOCALE void                           set_parsed_bindings(void *, struct binding
 LOCALE void                           clear_parsed_bindings(void *);
 LOCALE BOOLEAN                        are_bindings_empty(void *);
 LOCALE int                            find_parsed_binding(void *, struct atom_hash_node *);
+LOCALE void                           resolve_parsed_bindings(void *, struct core_expression *);
 LOCALE int                            get_binding_count_in_current_context(void *);
 LOCALE void                           remove_binding(void *, struct atom_hash_node *);
 
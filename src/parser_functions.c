@@ -28,6 +28,9 @@
 #include "router.h"
 #include "core_scanner.h"
 #include "type_symbol.h"
+#if BYTECODE_FUNCTIONS
+#include "core_bytecode.h"
+#endif
 
 #define __PARSER_FUNCTIONS_SOURCE__
 #include "parser_functions.h"
@@ -389,6 +392,9 @@ static FUNCTION_DEFINITION *_add_function(void *env, ATOM_HN *name, core_express
         core_init_construct_header(env, FUNC_NAME_CREATE_FUNC, (struct construct_metadata *)dfuncPtr, name);
         inc_atom_count(name);
         dfuncPtr->code = NULL;
+#if BYTECODE_FUNCTIONS
+        dfuncPtr->bytecode = NULL;
+#endif
         dfuncPtr->min_args = min;
         dfuncPtr->max_args = max;
         dfuncPtr->local_variable_count = lvars;
@@ -408,6 +414,10 @@ static FUNCTION_DEFINITION *_add_function(void *env, ATOM_HN *name, core_express
         dfuncPtr->busy = oldbusy;
         core_return_packed_expression(env, dfuncPtr->code);
         dfuncPtr->code = NULL;
+#if BYTECODE_FUNCTIONS
+        core_bytecode_release(env, dfuncPtr->bytecode);
+        dfuncPtr->bytecode = NULL;
+#endif
         set_function_pp((void *)dfuncPtr, NULL);
 
         /* =======================================
@@ -21,10 +21,20 @@
 
 #include "router.h"
 
+#if UNIX_V || UNIX_7 || LINUX || DARWIN
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#define ROUTER_MMAP 1
+#else
+#define ROUTER_MMAP 0
+#endif
+
 /**************************************
  * LOCAL FUNCTION PROTOTYPES
  ***************************************/
 static int  _query_router(void *, char *, struct router *);
+static struct router *_find_router(void *, char *, int);
 static void _delete_router_data(void *);
 static BOOLEAN _add_contextual_router(void *,
                                       char *, int,
@@ -44,6 +54,7 @@ void init_routers(void *env)
 
     get_router_data(env)->command_buffer_input_count = 0;
     get_router_data(env)->is_waiting = TRUE;
+    get_router_data(env)->cache_epoch = 1;
 
     core_define_function(env, FUNC_NAME_QUIT, RT_VOID, PTR_FN broccoli_quit, "ExitCommand", FUNC_CNSTR_QUIT);
     init_file_router(env);
@@ -94,27 +105,22 @@ int print_router(void *env, char *logicalName, char *str)
      * is found that will handle the print request.
      *==============================================*/
 
-    currentPtr = get_router_data(env)->routers_list;
+    currentPtr = _find_router(env, logicalName, ROUTER_CACHE_PRINT);
 
-    while( currentPtr != NULL )
+    if( currentPtr != NULL )
     {
-        if((currentPtr->printer != NULL) ? _query_router(env, logicalName, currentPtr) : FALSE )
-        {
-            core_set_environment_router_context(env, currentPtr->context);
+        core_set_environment_router_context(env, currentPtr->context);
 
-            if( currentPtr->environment_aware )
-            {
-                (*currentPtr->printer)(env, logicalName, str);
-            }
-            else
-            {
-                ((int(*) (char *, char *))(*currentPtr->printer))(logicalName, str);
-            }
-
-            return(1);
+        if( currentPtr->environment_aware )
+        {
+            (*currentPtr->printer)(env, logicalName, str);
+        }
+        else
+        {
+            ((int(*) (char *, char *))(*currentPtr->printer))(logicalName, str);
         }
 
-        currentPtr = currentPtr->next;
+        return(1);
     }
 
     /*=====================================================
@@ -140,13 +146,13 @@ int get_ch_router(void *env, char *logicalName)
     /*===================================================
      * If the "fast load" option is being used, then the
      * logical name is actually a pointer to a file and
-     * getc can be called directly to bypass querying
-     * all of the routers.
+     * the character is taken straight from its buffer,
+     * bypassing the query of all of the routers.
      *===================================================*/
 
     if(((char *)get_router_data(env)->fast_load_file_ptr) == logicalName )
     {
-        inchar = getc(get_router_data(env)->fast_load_file_ptr);
+        inchar = router_buffer_get_ch(env, get_router_data(env)->fast_load_buffer);
 
         if((inchar == '\r') || (inchar == '\n'))
         {
@@ -197,42 +203,37 @@ int get_ch_router(void *env, char *logicalName)
      * is found that will handle the getc request.
      *==============================================*/
 
-    currentPtr = get_router_data(env)->routers_list;
+    currentPtr = _find_router(env, logicalName, ROUTER_CACHE_GET_CH);
 
-    while( currentPtr != NULL )
+    if( currentPtr != NULL )
     {
-        if((currentPtr->charget != NULL) ? _query_router(env, logicalName, currentPtr) : FALSE )
-        {
-            core_set_environment_router_context(env, currentPtr->context);
+        core_set_environment_router_context(env, currentPtr->context);
 
-            if( currentPtr->environment_aware )
-            {
-                inchar = (*currentPtr->charget)(env, logicalName);
-            }
-            else
-            {
-                inchar = ((int(*) (char *))(*currentPtr->charget))(logicalName);
-            }
+        if( currentPtr->environment_aware )
+        {
+            inchar = (*currentPtr->charget)(env, logicalName);
+        }
+        else
+        {
+            inchar = ((int(*) (char *))(*currentPtr->charget))(logicalName);
+        }
 
-            if((inchar == '\r') || (inchar == '\n'))
+        if((inchar == '\r') || (inchar == '\n'))
+        {
+            if((get_router_data(env)->line_count_router != NULL) &&
+               (strcmp(logicalName, get_router_data(env)->line_count_router) == 0))
             {
-                if((get_router_data(env)->line_count_router != NULL) &&
-                   (strcmp(logicalName, get_router_data(env)->line_count_router) == 0))
-                {
-                    core_inc_line_count(env);
-                }
+                core_inc_line_count(env);
             }
-
-            /* if (inchar == '\r') return('\n'); */
-
-            /*
-             * if (inchar != '\b')
-             * { return(inchar); }
-             */
-            return(inchar);
         }
 
-        currentPtr = currentPtr->next;
+        /* if (inchar == '\r') return('\n'); */
+
+        /*
+         * if (inchar != '\b')
+         * { return(inchar); }
+         */
+        return(inchar);
     }
 
     /*=====================================================
@@ -253,8 +254,7 @@ int unget_ch_router(void *env, int ch, char *logicalName)
     /*===================================================*/
     /* If the "fast load" option is being used, then the */
     /* logical name is actually a pointer to a file and  */
-    /* ungetc can be called directly to bypass querying  */
-    /* all of the routers.                               */
+    /* the character is put back in its buffer directly. */
     /*===================================================*/
 
     if(((char *)get_router_data(env)->fast_load_file_ptr) == logicalName )
@@ -267,7 +267,7 @@ int unget_ch_router(void *env, int ch, char *logicalName)
             }
         }
 
-        return(ungetc(ch, get_router_data(env)->fast_load_file_ptr));
+        return(router_buffer_unget_ch(get_router_data(env)->fast_load_buffer, ch));
     }
 
     /*===============================================*/
@@ -300,34 +300,29 @@ int unget_ch_router(void *env, int ch, char *logicalName)
     /* is found that will handle the ungetc request. */
     /*===============================================*/
 
-    currentPtr = get_router_data(env)->routers_list;
+    currentPtr = _find_router(env, logicalName, ROUTER_CACHE_UNGET_CH);
 
-    while( currentPtr != NULL )
+    if( currentPtr != NULL )
     {
-        if((currentPtr->charunget != NULL) ? _query_router(env, logicalName, currentPtr) : FALSE )
+        if((ch == '\r') || (ch == '\n'))
         {
-            if((ch == '\r') || (ch == '\n'))
+            if((get_router_data(env)->line_count_router != NULL) &&
+               (strcmp(logicalName, get_router_data(env)->line_count_router) == 0))
             {
-                if((get_router_data(env)->line_count_router != NULL) &&
-                   (strcmp(logicalName, get_router_data(env)->line_count_router) == 0))
-                {
-                    core_dec_line_count(env);
-                }
+                core_dec_line_count(env);
             }
+        }
 
-            core_set_environment_router_context(env, currentPtr->context);
+        core_set_environment_router_context(env, currentPtr->context);
 
-            if( currentPtr->environment_aware )
-            {
-                return((*currentPtr->charunget)(env, ch, logicalName));
-            }
-            else
-            {
-                return(((int(*) (int, char *))(*currentPtr->charunget))(ch, logicalName));
-            }
+        if( currentPtr->environment_aware )
+        {
+            return((*currentPtr->charunget)(env, ch, logicalName));
+        }
+        else
+        {
+            return(((int(*) (int, char *))(*currentPtr->charunget))(ch, logicalName));
         }
-
-        currentPtr = currentPtr->next;
     }
 
     /*=====================================================*/
@@ -457,6 +452,8 @@ BOOLEAN _add_contextual_router(void *env, char *routerName, int priority, int (*
     newPtr->charunget = ungetcFunction;
     newPtr->next = NULL;
 
+    router_cache_invalidate(env);
+
     if( get_router_data(env)->routers_list == NULL )
     {
         get_router_data(env)->routers_list = newPtr;
@@ -500,6 +497,7 @@ int delete_router(void *env, char *routerName)
     {
         if( strcmp(currentPtr->name, routerName) == 0 )
         {
+            router_cache_invalidate(env);
             core_mem_free(env, currentPtr->name, strlen(currentPtr->name) + 1);
 
             if( lastPtr == NULL )
@@ -526,21 +524,104 @@ int delete_router(void *env, char *routerName)
  *********************************************************************/
 int query_router(void *env, char *logicalName)
 {
+    if( _find_router(env, logicalName, ROUTER_CACHE_QUERY) != NULL )
+    {
+        return(TRUE);
+    }
+
+    return(FALSE);
+}
+
+/*********************************************************
+ * FindRouter: Returns the first router that recognizes a
+ *   logical name and can handle the given kind of request.
+ *   The answer is remembered until the set of routers or
+ *   the names they recognize changes.
+ **********************************************************/
+static struct router *_find_router(void *env, char *logicalName, int kind)
+{
+    struct router_data *data = get_router_data(env);
+    struct router_cache_entry *entry;
     struct router *currentPtr;
+    int handles;
 
-    currentPtr = get_router_data(env)->routers_list;
+    entry = &data->cache[kind][((size_t)logicalName >> 3) & (ROUTER_CACHE_SIZE - 1)];
 
-    while( currentPtr != NULL )
+    if((entry->logical_name == logicalName) &&
+       (entry->epoch == data->cache_epoch) &&
+       (strcmp(entry->name, logicalName) == 0))
+    {
+        return(entry->router);
+    }
+
+    for( currentPtr = data->routers_list;
+         currentPtr != NULL;
+         currentPtr = currentPtr->next )
     {
-        if( _query_router(env, logicalName, currentPtr) == TRUE )
+        switch( kind )
         {
-            return(TRUE);
+        case ROUTER_CACHE_PRINT:
+            handles = (currentPtr->printer != NULL);
+            break;
+        case ROUTER_CACHE_GET_CH:
+            handles = (currentPtr->charget != NULL);
+            break;
+        case ROUTER_CACHE_UNGET_CH:
+            handles = (currentPtr->charunget != NULL);
+            break;
+        default:
+            handles = TRUE;
+            break;
         }
 
-        currentPtr = currentPtr->next;
+        if( handles && _query_router(env, logicalName, currentPtr))
+        {
+            break;
+        }
     }
 
-    return(FALSE);
+    if((currentPtr != NULL) && (strlen(logicalName) < ROUTER_CACHE_NAME_SZ))
+    {
+        entry->logical_name = logicalName;
+        sysdep_strcpy(entry->name, logicalName);
+        entry->epoch = data->cache_epoch;
+        entry->router = currentPtr;
+    }
+
+    return(currentPtr);
+}
+
+/*********************************************************
+ * router_cache_invalidate: Drops every cached router
+ *   lookup. Called whenever a router is added, removed,
+ *   activated or deactivated.
+ **********************************************************/
+void router_cache_invalidate(void *env)
+{
+    get_router_data(env)->cache_epoch++;
+}
+
+/*********************************************************
+ * router_cache_forget: Drops the cached lookups for one
+ *   logical name. Called by routers when they start or
+ *   stop recognizing that name.
+ **********************************************************/
+void router_cache_forget(void *env, char *logicalName)
+{
+    struct router_data *data = get_router_data(env);
+    int kind, i;
+
+    for( kind = 0; kind < ROUTER_CACHE_KINDS; kind++ )
+    {
+        for( i = 0; i < ROUTER_CACHE_SIZE; i++ )
+        {
+            if((data->cache[kind][i].logical_name != NULL) &&
+               (strcmp(data->cache[kind][i].name, logicalName) == 0))
+            {
+                data->cache[kind][i].logical_name = NULL;
+            }
+        }
+    }
 }
 
 /***********************************************
@@ -606,6 +687,7 @@ int deactivate_router(void *env, char *routerName)
         if( strcmp(currentPtr->name, routerName) == 0 )
         {
             currentPtr->active = FALSE;
+            router_cache_invalidate(env);
             return(TRUE);
         }
 
@@ -629,6 +711,7 @@ int activate_router(void *env, char *routerName)
         if( strcmp(currentPtr->name, routerName) == 0 )
         {
             currentPtr->active = TRUE;
+            router_cache_invalidate(env);
             return(TRUE);
         }
 
@@ -640,12 +723,159 @@ int activate_router(void *env, char *routerName)
 
 /*******************************************************
  * set_fast_load: Used to bypass router system for loads.
+ *   The file is read through a router buffer until the
+ *   fast load is turned off again.
  ********************************************************/
 void set_fast_load(void *env, FILE *filePtr)
 {
+    if( get_router_data(env)->fast_load_buffer != NULL )
+    {
+        router_buffer_close(env, get_router_data(env)->fast_load_buffer);
+        get_router_data(env)->fast_load_buffer = NULL;
+    }
+
+    if( filePtr != NULL )
+    {
+        get_router_data(env)->fast_load_buffer = router_buffer_open(env, filePtr);
+    }
+
     get_router_data(env)->fast_load_file_ptr = filePtr;
 }
 
+/*****************************************************
+ * get_router_buffer: Returns the buffer behind a
+ *   logical name if its input can be scanned directly,
+ *   otherwise NULL.
+ ******************************************************/
+struct router_buffer *get_router_buffer(void *env, char *logicalName)
+{
+    if(((char *)get_router_data(env)->fast_load_file_ptr) == logicalName )
+    {
+        return(get_router_data(env)->fast_load_buffer);
+    }
+
+    return(NULL);
+}
+
+/*****************************************************
+ * router_buffer_open: Creates a buffer reading from
+ *   the current position of a file. The file stays
+ *   open and belongs to the caller.
+ ******************************************************/
+struct router_buffer *router_buffer_open(void *env, FILE *theFile)
+{
+    struct router_buffer *buf;
+
+#if ROUTER_MMAP
+    struct stat fileInfo;
+    long start;
+    void *mapping;
+#endif
+
+    buf = core_mem_get_struct(env, router_buffer);
+    buf->data = NULL;
+    buf->size = 0;
+    buf->position = 0;
+    buf->capacity = 0;
+    buf->file = theFile;
+    buf->mapped = FALSE;
+
+#if ROUTER_MMAP
+
+    /*==============================================
+     * Map regular files so that the whole file is
+     * available without copying it.
+     *==============================================*/
+
+    start = ftell(theFile);
+
+    if((start >= 0) && (fstat(fileno(theFile), &fileInfo) == 0) &&
+       S_ISREG(fileInfo.st_mode) && (fileInfo.st_size > start))
+    {
+        mapping = mmap(NULL, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, fileno(theFile), 0);
+
+        if( mapping != MAP_FAILED )
+        {
+            buf->data = (char *)mapping;
+            buf->size = (size_t)fileInfo.st_size;
+            buf->position = (size_t)start;
+            buf->mapped = TRUE;
+            return(buf);
+        }
+    }
+
+#endif
+
+    buf->capacity = ROUTER_BUFFER_SIZE;
+    buf->data = (char *)core_mem_alloc_no_init(env, buf->capacity);
+
+    return(buf);
+}
+
+/*****************************************************
+ * router_buffer_close: Releases a router buffer.
+ ******************************************************/
+void router_buffer_close(void *env, struct router_buffer *buf)
+{
+    if( buf == NULL )
+    {
+        return;
+    }
+
+#if ROUTER_MMAP
+
+    if( buf->mapped )
+    {
+        munmap((void *)buf->data, buf->size);
+    }
+    else
+#endif
+    {
+        core_mem_release(env, buf->data, buf->capacity);
+    }
+
+    core_mem_return_struct(env, router_buffer, buf);
+}
+
+/*****************************************************
+ * router_buffer_fill: Reads the next block of a file
+ *   that isn't mapped. Returns FALSE at end of file.
+ ******************************************************/
+BOOLEAN router_buffer_fill(void *env, struct router_buffer *buf)
+{
+    size_t keep, count;
+
+    if( buf->mapped || (buf->file == NULL))
+    {
+        return(FALSE);
+    }
+
+    keep = (buf->size < ROUTER_BUFFER_KEEP) ? buf->size : ROUTER_BUFFER_KEEP;
+    memmove(buf->data, buf->data + buf->size - keep, keep);
+
+    count = fread(buf->data + keep, 1, buf->capacity - keep, buf->file);
+
+    buf->size = keep + count;
+    buf->position = keep;
+
+    return((count > 0) ? TRUE : FALSE);
+}
+
+/*****************************************************
+ * router_buffer_fill_ch: Called by router_buffer_get_ch
+ *   when the buffer has been used up. Refills it and
+ *   returns the next character or EOF.
+ ******************************************************/
+int router_buffer_fill_ch(void *env, struct router_buffer *buf)
+{
+    if( router_buffer_fill(env, buf) == FALSE )
+    {
+        return(EOF);
+    }
+
+    return((int)(unsigned char)buf->data[buf->position++]);
+}
+
 /*******************************************************
  * set_fast_save: Used to bypass router system for saves.
  ********************************************************/
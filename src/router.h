@@ -22,6 +22,35 @@
 
 #define ROUTER_DATA_INDEX 46
 
+/*==================================================
+ * A router buffer hands its reader a contiguous
+ * block of input. Regular files are mapped into
+ * memory whole where the system allows it, other
+ * files are read ROUTER_BUFFER_SIZE bytes at a
+ * time. A refill keeps the last two bytes so that
+ * two characters can always be put back.
+ *==================================================*/
+#define ROUTER_BUFFER_SIZE  65536
+#define ROUTER_BUFFER_KEEP  2
+
+struct router_buffer
+{
+    char *  data;
+    size_t  size;
+    size_t  position;
+    size_t  capacity;
+    FILE *  file;
+    int     mapped;
+};
+
+#define router_buffer_get_ch(env, buf) \
+    (((buf)->position < (buf)->size) ? \
+     (int)(unsigned char)(buf)->data[(buf)->position++] : \
+     router_buffer_fill_ch(env, buf))
+
+#define router_buffer_unget_ch(buf, ch) \
+    ((((ch) != EOF) && ((buf)->position > 0)) ? ((buf)->position--, (ch)) : (ch))
+
 struct router
 {
     char *         name;
@@ -37,6 +66,32 @@ struct router
     struct router *next;
 };
 
+/*==================================================
+ * Routers resolved for a logical name are kept in
+ * a small direct mapped cache, one table for each
+ * kind of request since a router need not handle
+ * all of them. An entry is keyed on the name
+ * pointer and checked against a copy of the name,
+ * so a reused buffer cannot hit a stale entry.
+ * Bumping the epoch drops every entry at once.
+ *==================================================*/
+#define ROUTER_CACHE_SIZE     32
+#define ROUTER_CACHE_NAME_SZ  32
+
+#define ROUTER_CACHE_PRINT    0
+#define ROUTER_CACHE_GET_CH   1
+#define ROUTER_CACHE_UNGET_CH 2
+#define ROUTER_CACHE_QUERY    3
+#define ROUTER_CACHE_KINDS    4
+
+struct router_cache_entry
+{
+    char *         logical_name;
+    char           name[ROUTER_CACHE_NAME_SZ];
+    unsigned long  epoch;
+    struct router *router;
+};
+
 struct router_data
 {
     size_t         command_buffer_input_count;
@@ -47,8 +102,11 @@ struct router_data
     long           fast_get_inde;
     struct router *routers_list;
     FILE *         fast_load_file_ptr;
+    struct router_buffer *fast_load_buffer;
     FILE *         fast_save_file_ptr;
     int            abort;
+    unsigned long  cache_epoch;
+    struct router_cache_entry cache[ROUTER_CACHE_KINDS][ROUTER_CACHE_SIZE];
 };
 
 #define get_router_data(env) ((struct router_data *)core_get_environment_data(env, ROUTER_DATA_INDEX))
@@ -82,10 +140,17 @@ LOCALE int                             delete_router(void *, char *);
 LOCALE int                             query_router(void *, char *);
 LOCALE int                             deactivate_router(void *, char *);
 LOCALE int                             activate_router(void *, char *);
+LOCALE void                            router_cache_invalidate(void *);
+LOCALE void                            router_cache_forget(void *, char *);
 LOCALE void                            set_fast_load(void *, FILE *);
 LOCALE void                            set_fast_save(void *, FILE *);
 LOCALE FILE                          * get_fast_load(void *);
 LOCALE FILE                          * get_fast_save(void *);
+LOCALE struct router_buffer          * get_router_buffer(void *, char *);
+LOCALE struct router_buffer          * router_buffer_open(void *, FILE *);
+LOCALE void                            router_buffer_close(void *, struct router_buffer *);
+LOCALE BOOLEAN                         router_buffer_fill(void *, struct router_buffer *);
+LOCALE int                             router_buffer_fill_ch(void *, struct router_buffer *);
 LOCALE void                            error_unknown_router(void *, char *);
 LOCALE void                            broccoli_quit(void *);
 
@@ -34,6 +34,7 @@ static FILE * _lookup_file_ptr(void *, char *);
 void init_file_router(void *env)
 {
     core_allocate_environment_data(env, FILE_ROUTER_DATA_INDEX, sizeof(struct file_router_data), _delete_file_router_data);
+    get_file_router_data(env)->buffer_size = FILE_ROUTER_BUFFER_SIZE;
 
     add_router(env, "fileio", 0, find_file,
                _print_file, _get_ch_file,
@@ -48,6 +49,11 @@ static void _delete_file_router_data(void *env)
 {
     struct file_router *tmpPtr, *nextPtr;
 
+    if( get_file_router_data(env)->stdout_pending )
+    {
+        fflush(stdout);
+    }
+
     tmpPtr = get_file_router_data(env)->file_routers_list;
 
     while( tmpPtr != NULL )
@@ -152,12 +158,9 @@ static int _exit_file(void *env, int num)
 #if MAC_MCW || WIN_MCW || MAC_XCD
 #pragma unused(num)
 #endif
+    flush_all_files(env);
 #if IO_FUNCTIONS
     close_all_files(env);
-#else
-#if MAC_MCW || WIN_MCW || MAC_XCD
-#pragma unused(env)
-#endif
 #endif
     return(1);
 }
@@ -170,8 +173,13 @@ static int _print_file(void *env, char *logicalName, char *str)
     FILE *fptr;
 
     fptr = _lookup_file_ptr(env, logicalName);
-    fprintf(fptr, "%s", str);
-    fflush(fptr);
+    fputs(str, fptr);
+
+    if( fptr == stdout )
+    {
+        get_file_router_data(env)->stdout_pending = TRUE;
+    }
+
     return(1);
 }
 
@@ -185,6 +193,17 @@ static int _get_ch_file(void *env, char *logicalName)
 
     fptr = _lookup_file_ptr(env, logicalName);
 
+    /*============================================
+     * Make sure a prompt written to stdout shows
+     * up before waiting for the user to answer.
+     *============================================*/
+
+    if((fptr == stdin) && get_file_router_data(env)->stdout_pending )
+    {
+        fflush(stdout);
+        get_file_router_data(env)->stdout_pending = FALSE;
+    }
+
     theChar = getc(fptr);
 
     /*=================================================
@@ -236,10 +255,17 @@ int open_file(void *env, char *fileName, char *accessMode, char *logicalName)
      * Create a new file router.
      *===========================*/
 
+    if( get_file_router_data(env)->buffer_size > 0 )
+    {
+        /* setvbuf must come before the first read or write. */
+        setvbuf(newstream, NULL, _IOFBF, get_file_router_data(env)->buffer_size);
+    }
+
     newRouter = core_mem_get_struct(env, file_router);
     newRouter->logical_name = (char *)core_mem_alloc_no_init(env, strlen(logicalName) + 1);
     sysdep_strcpy(newRouter->logical_name, logicalName);
     newRouter->stream = newstream;
+    newRouter->output = ((accessMode[0] != 'r') || (strchr(accessMode, '+') != NULL));
 
     /*==========================================
      * Add the newly opened file to the list of
@@ -248,6 +274,7 @@ int open_file(void *env, char *fileName, char *accessMode, char *logicalName)
 
     newRouter->next = get_file_router_data(env)->file_routers_list;
     get_file_router_data(env)->file_routers_list = newRouter;
+    router_cache_forget(env, logicalName);
 
     /*==================================
      * Return TRUE to indicate the file
@@ -272,6 +299,7 @@ int close_file(void *env, char *fid)
     {
         if( strcmp(fptr->logical_name, fid) == 0 )
         {
+            router_cache_forget(env, fptr->logical_name);
             sysdep_close_file(env, fptr->stream);
             core_mem_release(env, fptr->logical_name, strlen(fptr->logical_name) + 1);
 
@@ -309,6 +337,7 @@ int close_all_files(void *env)
         return(FALSE);
     }
 
+    router_cache_invalidate(env);
     fptr = get_file_router_data(env)->file_routers_list;
 
     while( fptr != NULL )
@@ -324,3 +353,72 @@ int close_all_files(void *env)
 
     return(TRUE);
 }
+
+/*************************************************************
+ * flush_file: Writes out anything buffered for the specified
+ *   logical name. Returns TRUE if the name belongs to the
+ *   file router, otherwise FALSE.
+ **************************************************************/
+int flush_file(void *env, char *logicalName)
+{
+    struct file_router *fptr;
+    FILE *stream;
+
+    stream = _lookup_file_ptr(env, logicalName);
+
+    if( stream == NULL )
+    {
+        return(FALSE);
+    }
+
+    if( stream == stdout )
+    {
+        fflush(stdout);
+        get_file_router_data(env)->stdout_pending = FALSE;
+        return(TRUE);
+    }
+
+    for( fptr = get_file_router_data(env)->file_routers_list;
+         fptr != NULL;
+         fptr = fptr->next )
+    {
+        if((fptr->stream == stream) && fptr->output )
+        {
+            fflush(stream);
+        }
+    }
+
+    return(TRUE);
+}
+
+/*************************************************************
+ * flush_all_files: Writes out anything buffered for stdout
+ *   and for every file opened through the file router.
+ **************************************************************/
+void flush_all_files(void *env)
+{
+    struct file_router *fptr;
+
+    fflush(stdout);
+    get_file_router_data(env)->stdout_pending = FALSE;
+
+    for( fptr = get_file_router_data(env)->file_routers_list;
+         fptr != NULL;
+         fptr = fptr->next )
+    {
+        if( fptr->output )
+        {
+            fflush(fptr->stream);
+        }
+    }
+}
+
+/*************************************************************
+ * set_file_buffer_size: Sets the size of the output buffer
+ *   given to files opened from now on. A size of zero keeps
+ *   the stdio default.
+ **************************************************************/
+void set_file_buffer_size(void *env, size_t size)
+{
+    get_file_router_data(env)->buffer_size = size;
+}
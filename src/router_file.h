@@ -11,16 +11,30 @@
 
 #define FILE_ROUTER_DATA_INDEX 47
 
+/*==================================================
+ * Output to files is no longer flushed after every
+ * fragment. Files opened with open_file get a
+ * buffer of buffer_size bytes and are flushed when
+ * it fills, on close, on exit or by flush_file.
+ * stdout keeps the stdio policy: line buffered on
+ * a terminal and block buffered otherwise, and it
+ * is flushed before anything is read from stdin.
+ *==================================================*/
+#define FILE_ROUTER_BUFFER_SIZE 8192
+
 struct file_router
 {
     char *              logical_name;
     FILE *              stream;
+    BOOLEAN             output;
     struct file_router *next;
 };
 
 struct file_router_data
 {
     struct file_router *file_routers_list;
+    size_t              buffer_size;
+    BOOLEAN             stdout_pending;
 };
 
 #define get_file_router_data(env) ((struct file_router_data *)core_get_environment_data(env, FILE_ROUTER_DATA_INDEX))
@@ -40,5 +54,8 @@ LOCALE int  open_file(void *, char *, char *, char *);
 LOCALE int  close_all_files(void *);
 LOCALE int  close_file(void *, char *);
 LOCALE int  find_file(void *, char *);
+LOCALE int  flush_file(void *, char *);
+LOCALE void flush_all_files(void *);
+LOCALE void set_file_buffer_size(void *, size_t);
 
 #endif
@@ -246,6 +246,7 @@ static int _create_r_str_source(void *env, char *name, char *str, size_t current
     newStringRouter->max_position = maximumPosition;
     newStringRouter->next = get_string_router_data(env)->string_router_list;
     get_string_router_data(env)->string_router_list = newStringRouter;
+    router_cache_forget(env, name);
 
     return(1);
 }
@@ -264,6 +265,8 @@ int close_string_source(void *env, char *name)
     {
         if( strcmp(head->name, name) == 0 )
         {
+            router_cache_forget(env, head->name);
+
             if( last == NULL )
             {
                 get_string_router_data(env)->string_router_list = head->next;
@@ -308,6 +311,7 @@ int open_string_dest(void *env, char *name, char *str, size_t maximumPosition)
     newStringRouter->max_position = maximumPosition;
     newStringRouter->next = get_string_router_data(env)->string_router_list;
     get_string_router_data(env)->string_router_list = newStringRouter;
+    router_cache_forget(env, name);
 
     return(1);
 }
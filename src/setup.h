@@ -109,6 +109,36 @@
 #define DEFFUNCTION_CONSTRUCT 1
 #endif
 
+/**************************************************************
+ * BYTECODE_FUNCTIONS:  Determines whether deffunction bodies
+ *   are compiled to bytecode and run by the dispatch loop in
+ *   core_bytecode.c.  The expression walker is used otherwise.
+ ***************************************************************/
+
+#ifndef BYTECODE_FUNCTIONS
+#define BYTECODE_FUNCTIONS 1
+#endif
+
+#if !DEFFUNCTION_CONSTRUCT
+#undef BYTECODE_FUNCTIONS
+#define BYTECODE_FUNCTIONS 0
+#endif
+
+/**************************************************************
+ * IMMEDIATE_NUMBERS:  Determines whether integers and floats
+ *   that fit are stored directly in the value pointer with a
+ *   tag in the low bits instead of in the hash tables.  Needs
+ *   64 bit pointers.
+ ***************************************************************/
+
+#ifndef IMMEDIATE_NUMBERS
+#if defined(__LP64__) || defined(_WIN64)
+#define IMMEDIATE_NUMBERS 1
+#else
+#define IMMEDIATE_NUMBERS 0
+#endif
+#endif
+
 /********************************************
  * DEFGENERIC_CONSTRUCT:  Determines whether
  *   generic functions  are included.
@@ -238,21 +268,19 @@
 #define PROFILING_FUNCTIONS 0
 #endif
 
-/***********************************************************************
- * BLOCK_MEMORY: Causes memory to be allocated in large blocks.
- *   INITBUFFERSIZE and BLOCKSIZE should both be set to less than the
- *   maximum size of a signed integer.
- ************************************************************************/
+/****************************************************
+ * SAMPLING_FUNCTIONS: Enables the profile-sample
+ *   function, which samples the executing
+ *   deffunctions on a profiling timer. Needs
+ *   setitimer and sigaction.
+ *****************************************************/
 
-#ifndef BLOCK_MEMORY
-#define BLOCK_MEMORY 0
+#ifndef SAMPLING_FUNCTIONS
+#if UNIX_V || UNIX_7 || LINUX || DARWIN
+#define SAMPLING_FUNCTIONS 1
+#else
+#define SAMPLING_FUNCTIONS 0
 #endif
-
-#if BLOCK_MEMORY
-
-#define INITBLOCKSIZE 32000
-#define BLOCKSIZE     32000
-
 #endif
 
 /*******************************************
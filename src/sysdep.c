@@ -82,6 +82,8 @@ extern int LIB $ SPAWN();
 #include "funcs_misc.h"
 #include "type_list.h"
 #include "funcs_list.h"
+#include "funcs_string_builder.h"
+#include "funcs_sampling.h"
 #include "core_functions_util.h"
 #include "funcs_predicate.h"
 #include "funcs_comparison.h"
@@ -466,6 +468,8 @@ static void _system_function_definitions(void *env)
     init_list_functions(env);
 #endif
 
+    init_string_builder_functions(env);
+
 #if STRING_FUNCTIONS
     StringFunctionDefinitions(env);
 #endif
@@ -478,6 +482,10 @@ static void _system_function_definitions(void *env)
 #if PROFILING_FUNCTIONS
     ConstructProfilingFunctionDefinitions(env);
 #endif
+
+#if SAMPLING_FUNCTIONS
+    init_sampling_functions(env);
+#endif
 }
 
 /********************************************************
@@ -490,6 +498,25 @@ double sysdep_time()
     return((double)clock() / (double)CLOCKS_PER_SEC);
 }
 
+/*********************************************************
+ * sysdep_clock_ns: Returns a monotonic wall clock reading
+ *   in nanoseconds. Falls back to the processor time from
+ *   clock when the system has no monotonic clock.
+ **********************************************************/
+long long sysdep_clock_ns()
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec now;
+
+    if( clock_gettime(CLOCK_MONOTONIC, &now) == 0 )
+    {
+        return((long long)now.tv_sec * 1000000000LL + (long long)now.tv_nsec);
+    }
+#endif
+
+    return((long long)((double)clock() * (1000000000.0 / (double)CLOCKS_PER_SEC)));
+}
+
 /****************************************************
  * sysdep_system: Generic routine for passing a string
  *   representing a command to the operating system.
@@ -574,6 +601,7 @@ void sysdep_system(void *env)
         (*get_sysdep_data(env)->fn_pause)(env);
     }
 
+    fflush(stdout);
     system(commandBuffer);
 
     if( get_sysdep_data(env)->fn_continue != NULL )
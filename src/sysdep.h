@@ -36,6 +36,7 @@
 LOCALE void init_system(void *, struct atom_hash_node **, struct float_hash_node **, struct integer_hash_node **, struct bitmap_hash_node **, struct external_address_hash_node **);
 LOCALE int sysdep_route_stdin(void *, int, char *[]);
 LOCALE double sysdep_time(void);
+LOCALE long long sysdep_clock_ns(void);
 LOCALE void   sysdep_system(void *env);
 LOCALE int    sysdep_open_r_binary(void *, char *, char *);
 LOCALE void   sysdep_seek_r_binary(void *, long);
@@ -23,7 +23,27 @@
  * LOCAL FUNCTION PROTOTYPES
  ***************************************/
 
-static void DeallocateListData(void *);
+static void          DeallocateListData(void *);
+static void          _release_list_block(void *, struct list_block *, int);
+static void          _release_list_segment(void *, struct list *, int);
+static struct list * _create_block_list(void *, struct list_block *, struct node *, long);
+static void          _copy_list_args(void *, struct node *, core_data_object *, long, long);
+static BOOLEAN       _extend_list_block(void *, core_data_object *, long, unsigned long, core_data_object *);
+static void          _add_to_generation(void *, struct list *);
+
+/*=================================================
+ * Bytes charged to the garbage heuristics for a
+ * list header and the cells it owns.
+ *=================================================*/
+#define LIST_GENERATION_SZ(seg) \
+    (sizeof(struct list) + sizeof(struct node) * \
+     ((((seg)->block != NULL) || ((seg)->length == 0)) ? 1 : (seg)->length))
+
+/*=================================================
+ * Free cells left on each side of a new block so
+ * later cats can prepend or append in place.
+ *=================================================*/
+#define LIST_BLOCK_SLACK(n) ((n) / 2 + 2)
 
 /**************************************************
  * init_list_data: Allocates environment
@@ -41,17 +61,71 @@ void init_list_data(void *env)
 static void DeallocateListData(void *env)
 {
     struct list *tmpPtr, *nextPtr;
+    int i;
+
+    for( i = 0; i < get_list_data(env)->generation_top; i++ )
+    {
+        tmpPtr = get_list_data(env)->generations[i];
 
-    tmpPtr = get_list_data(env)->all_lists;
+        while( tmpPtr != NULL )
+        {
+            nextPtr = tmpPtr->next;
+            _release_list_segment(env, tmpPtr, FALSE);
+            tmpPtr = nextPtr;
+        }
+    }
 
-    while( tmpPtr != NULL )
+    if( get_list_data(env)->generation_max > 0 )
     {
-        nextPtr = tmpPtr->next;
-        release_list(env, tmpPtr);
-        tmpPtr = nextPtr;
+        core_mem_free(env, get_list_data(env)->generations, sizeof(struct list *) * get_list_data(env)->generation_max);
     }
 }
 
+/****************************************************
+ * _add_to_generation: Adds a garbage list to the
+ *   generation for the depth it was created at,
+ *   growing the generation table if needed.
+ *****************************************************/
+static void _add_to_generation(void *env, struct list *list_segment)
+{
+    struct list_data *data = get_list_data(env);
+    int generation, newMax, i;
+
+    generation = (list_segment->depth < 0) ? 0 : list_segment->depth;
+
+    if( generation >= data->generation_max )
+    {
+        newMax = (data->generation_max == 0) ? 16 : data->generation_max;
+
+        while( newMax <= generation )
+        {
+            newMax *= 2;
+        }
+
+        data->generations = (struct list **)
+                            core_mem_realloc(env, data->generations, sizeof(struct list *) * data->generation_max,
+                                             sizeof(struct list *) * newMax);
+
+        for( i = data->generation_max; i < newMax; i++ )
+        {
+            data->generations[i] = NULL;
+        }
+
+        data->generation_max = newMax;
+    }
+
+    list_segment->next = data->generations[generation];
+    data->generations[generation] = list_segment;
+
+    if( generation >= data->generation_top )
+    {
+        data->generation_top = generation + 1;
+    }
+
+    core_get_gc_data(env)->generational_item_count++;
+    core_get_gc_data(env)->generational_item_sz += LIST_GENERATION_SZ(list_segment);
+}
+
 /**********************************************************
  * create_sized_list:
  ***********************************************************/
@@ -71,6 +145,8 @@ void *create_sized_list(void *env, long size)
     list_segment->depth = (short)core_get_evaluation_data(env)->eval_depth;
     list_segment->busy_count = 0;
     list_segment->next = NULL;
+    list_segment->block = NULL;
+    list_segment->cell = list_segment->fields;
 
     return((void *)list_segment);
 }
@@ -79,6 +155,18 @@ void *create_sized_list(void *env, long size)
  * release_list:
  *****************************************************************/
 void release_list(void *env, struct list *list_segment)
+{
+    _release_list_segment(env, list_segment, TRUE);
+}
+
+/****************************************************************
+ * _release_list_segment: Frees a list. The header of a list
+ *   that shares a block was allocated without cells of its
+ *   own, so it is released at that size whatever its length.
+ *   The block goes with its last list, uninstalling its values
+ *   unless the environment is being torn down.
+ *****************************************************************/
+static void _release_list_segment(void *env, struct list *list_segment, int uninstall)
 {
     unsigned long newSize;
 
@@ -87,7 +175,16 @@ void release_list(void *env, struct list *list_segment)
         return;
     }
 
-    if( list_segment->length == 0 )
+    if( list_segment->block != NULL )
+    {
+        if( --list_segment->block->references == 0 )
+        {
+            _release_list_block(env, list_segment->block, uninstall);
+        }
+
+        newSize = 1;
+    }
+    else if( list_segment->length == 0 )
     {
         newSize = 1;
     }
@@ -99,6 +196,27 @@ void release_list(void *env, struct list *list_segment)
     core_mem_release_dynamic_struct(env, list, sizeof(struct node) * (newSize - 1), list_segment);
 }
 
+/****************************************************************
+ * _release_list_block: Frees a shared block once no list refers
+ *   to it, dropping the references it holds on its values.
+ *****************************************************************/
+static void _release_list_block(void *env, struct list_block *block, int uninstall)
+{
+    long i;
+
+    if( uninstall )
+    {
+        for( i = block->front; i < block->back; i++ )
+        {
+            core_decrement_atom(env, block->cells[i].type, block->cells[i].value);
+        }
+    }
+
+    core_get_gc_data(env)->generational_item_sz -= sizeof(struct list_block) +
+                                                   (sizeof(struct node) * (block->capacity - 1));
+    core_mem_release_dynamic_struct(env, list_block, sizeof(struct node) * (block->capacity - 1), block);
+}
+
 /*****************************
  * install_list:
  ******************************/
@@ -112,9 +230,14 @@ void install_list(void *env, struct list *list_segment)
         return;
     }
 
-    length = list_segment->length;
-
     list_segment->busy_count++;
+
+    if( list_segment->block != NULL )
+    {
+        return;
+    }
+
+    length = list_segment->length;
     theFields = list_segment->cell;
 
     for( i = 0 ; i < length ; i++ )
@@ -136,8 +259,14 @@ void uninstall_list(void *env, struct list *list_segment)
         return;
     }
 
-    length = list_segment->length;
     list_segment->busy_count--;
+
+    if( list_segment->block != NULL )
+    {
+        return;
+    }
+
+    length = list_segment->length;
     theFields = list_segment->cell;
 
     for( i = 0 ; i < length ; i++ )
@@ -259,12 +388,10 @@ void *create_list(void *env, long size)
     list_segment->depth = (short)core_get_evaluation_data(env)->eval_depth;
     list_segment->busy_count = 0;
     list_segment->next = NULL;
+    list_segment->block = NULL;
+    list_segment->cell = list_segment->fields;
 
-    list_segment->next = get_list_data(env)->all_lists;
-    get_list_data(env)->all_lists = list_segment;
-
-    core_get_gc_data(env)->generational_item_count++;
-    core_get_gc_data(env)->generational_item_sz += sizeof(struct list) + (sizeof(struct node) * newSize);
+    _add_to_generation(env, list_segment);
 
     return((void *)list_segment);
 }
@@ -295,65 +422,95 @@ void *convert_data_object_to_list(void *env, core_data_object *val)
 void track_list(void *env, struct list *list_segment)
 {
     list_segment->depth = (short)core_get_evaluation_data(env)->eval_depth;
-    list_segment->next = get_list_data(env)->all_lists;
-    get_list_data(env)->all_lists = list_segment;
-
-    core_get_gc_data(env)->generational_item_count++;
-    core_get_gc_data(env)->generational_item_sz += sizeof(struct list) + (sizeof(struct node) * list_segment->length);
+    _add_to_generation(env, list_segment);
 }
 
 /**********************************************************
- * flush_lists:
+ * flush_lists: Frees the garbage lists that are no longer
+ *   in use. Lists are kept in one generation per creation
+ *   depth, so only the generations deeper than the current
+ *   evaluation depth are visited. A list whose depth was
+ *   lowered when it was returned as a value is moved down
+ *   to its new generation as it is found.
  ***********************************************************/
 void flush_lists(void *env)
 {
-    struct list *list_segment, *nextPtr, *lastPtr = NULL;
-    unsigned long newSize;
+    struct list_data *data = get_list_data(env);
+    struct list *list_segment, *nextPtr;
+    int generation, depth, target;
 
-    list_segment = get_list_data(env)->all_lists;
+    depth = core_get_evaluation_data(env)->eval_depth;
 
-    while( list_segment != NULL )
+    for( generation = data->generation_top - 1; generation > depth; generation-- )
     {
-        nextPtr = list_segment->next;
+        list_segment = data->generations[generation];
+        data->generations[generation] = NULL;
 
-        if((list_segment->depth > core_get_evaluation_data(env)->eval_depth) && (list_segment->busy_count == 0))
+        while( list_segment != NULL )
         {
-            core_get_gc_data(env)->generational_item_count--;
-            core_get_gc_data(env)->generational_item_sz -= sizeof(struct list) +
-                                                           (sizeof(struct node) * list_segment->length);
+            nextPtr = list_segment->next;
 
-            if( list_segment->length == 0 )
+            if((list_segment->depth > depth) && (list_segment->busy_count == 0))
             {
-                newSize = 1;
+                core_get_gc_data(env)->generational_item_count--;
+                core_get_gc_data(env)->generational_item_sz -= LIST_GENERATION_SZ(list_segment);
+                release_list(env, list_segment);
             }
             else
             {
-                newSize = list_segment->length;
+                target = (list_segment->depth < 0) ? 0 : list_segment->depth;
+                list_segment->next = data->generations[target];
+                data->generations[target] = list_segment;
             }
 
-            core_mem_release_dynamic_struct(env, list, sizeof(struct node) * (newSize - 1), list_segment);
-
-            if( lastPtr == NULL )
-            {
-                get_list_data(env)->all_lists = nextPtr;
-            }
-            else
-            {
-                lastPtr->next = nextPtr;
-            }
-        }
-        else
-        {
-            lastPtr = list_segment;
+            list_segment = nextPtr;
         }
+    }
+
+    while((data->generation_top > 0) && (data->generations[data->generation_top - 1] == NULL))
+    {
+        data->generation_top--;
+    }
+}
+
+/**********************************************************
+ * get_list_generation_count: Returns the number of list
+ *   generations, one past the deepest that holds a list.
+ ***********************************************************/
+int get_list_generation_count(void *env)
+{
+    return(get_list_data(env)->generation_top);
+}
+
+/**********************************************************
+ * get_list_generation_stats: Counts the garbage lists in
+ *   a generation and the bytes charged for them against
+ *   the garbage collection heuristics.
+ ***********************************************************/
+void get_list_generation_stats(void *env, int generation, long *count, long *size)
+{
+    struct list *list_segment;
+
+    *count = 0;
+    *size = 0;
+
+    if((generation < 0) || (generation >= get_list_data(env)->generation_top))
+    {
+        return;
+    }
 
-        list_segment = nextPtr;
+    for( list_segment = get_list_data(env)->generations[generation];
+         list_segment != NULL;
+         list_segment = list_segment->next )
+    {
+        (*count)++;
+        *size += (long)LIST_GENERATION_SZ(list_segment);
     }
 }
 
 /********************************************************************
  * clone_list: Allocates a new segment and copies results from
- *                  old value to new - NOT put on all_lists!!
+ *                  old value to new - NOT put in a generation!!
  *********************************************************************/
 void clone_list(void *env, core_data_object_ptr dst, core_data_object_ptr src)
 {
@@ -746,14 +903,6 @@ unsigned long hash_list(struct list *list_segment, unsigned long theRange)
     return(count);
 }
 
-/*********************
- * get_all_lists:
- **********************/
-struct list *get_all_lists(void *env)
-{
-    return(get_list_data(env)->all_lists);
-}
-
 /**************************************
  * implode_list: C access routine
  *   for the implode$ function.
@@ -1046,15 +1195,44 @@ void concatenate_lists(void *env, core_data_object *ret, core_expression_object
             core_set_data_ptr_end(val_arr + i - 1, end);
         }
 
+        /*==========================================
+         * Garbage segments are built in a shared
+         * block, extending an argument's block in
+         * place when the free cells next to it
+         * are still unclaimed.
+         *==========================================*/
+
         if( garbageSegment )
         {
-            list = (struct list *)create_list(env, seg_size);
-        }
-        else
-        {
-            list = (struct list *)create_sized_list(env, seg_size);
+            if( _extend_list_block(env, val_arr, argCount, seg_size, ret) == FALSE )
+            {
+                struct list_block *block;
+                long capacity;
+
+                capacity = (long)seg_size + 2 * LIST_BLOCK_SLACK((long)seg_size);
+                block = core_mem_get_dynamic_struct(env, list_block, (long)sizeof(struct node) * (capacity - 1L));
+                block->references = 0;
+                block->capacity = capacity;
+                block->front = block->back = LIST_BLOCK_SLACK((long)seg_size);
+                core_get_gc_data(env)->generational_item_sz += sizeof(struct list_block) +
+                                                               (sizeof(struct node) * (capacity - 1));
+
+                list = _create_block_list(env, block, block->cells + block->back, (long)seg_size);
+                _copy_list_args(env, list->cell, val_arr, 0, argCount);
+                block->back += (long)seg_size;
+
+                core_set_pointer_type(ret, LIST);
+                core_set_data_ptr_start(ret, 1);
+                core_set_data_ptr_end(ret, (long)seg_size);
+                core_set_pointer_value(ret, (void *)list);
+            }
+
+            core_mem_release_sized(env, val_arr, (long)sizeof(core_data_object) * argCount);
+            return;
         }
 
+        list = (struct list *)create_sized_list(env, seg_size);
+
         /*========================================
          * Copy each argument into new segment.
          *========================================*/
@@ -1093,3 +1271,140 @@ void concatenate_lists(void *env, core_data_object *ret, core_expression_object
         return;
     }
 }
+
+/************************************************************
+ * _create_block_list: Creates a garbage list whose cells
+ *   are the length cells of a shared block starting at cell.
+ *************************************************************/
+static struct list *_create_block_list(void *env, struct list_block *block, struct node *cell, long length)
+{
+    struct list *list_segment;
+
+    list_segment = core_mem_get_dynamic_struct(env, list, 0L);
+
+    list_segment->length = length;
+    list_segment->depth = (short)core_get_evaluation_data(env)->eval_depth;
+    list_segment->busy_count = 0;
+    list_segment->block = block;
+    list_segment->cell = cell;
+    block->references++;
+
+    _add_to_generation(env, list_segment);
+
+    return(list_segment);
+}
+
+/************************************************************
+ * _copy_list_args: Copies the evaluated cat arguments
+ *   [from, to) into consecutive cells of a shared block,
+ *   taking the block's reference on each value.
+ *************************************************************/
+static void _copy_list_args(void *env, struct node *dst, core_data_object *val_arr, long from, long to)
+{
+    struct list *orig_ptr;
+    long k, i;
+
+    for( k = from; k < to; k++ )
+    {
+        if( core_get_pointer_type(val_arr + k) == LIST )
+        {
+            orig_ptr = (struct list *)core_get_pointer_value(val_arr + k);
+
+            for( i = core_get_data_ptr_start(val_arr + k); i <= core_get_data_ptr_end(val_arr + k); i++, dst++ )
+            {
+                dst->type = get_list_node_type(orig_ptr, i);
+                dst->value = get_list_node_value(orig_ptr, i);
+                core_install_data(env, dst->type, dst->value);
+            }
+        }
+        else if( core_get_pointer_type(val_arr + k) != RVOID )
+        {
+            dst->type = (unsigned short)core_get_pointer_type(val_arr + k);
+            dst->value = core_get_pointer_value(val_arr + k);
+            core_install_data(env, dst->type, dst->value);
+            dst++;
+        }
+    }
+}
+
+/************************************************************
+ * _extend_list_block: Looks for a list argument of cat that
+ *   is a window onto a shared block with enough unclaimed
+ *   cells on each side to hold the other arguments. If one
+ *   is found, the other arguments are copied into those
+ *   cells and the result shares the block, so building a
+ *   list one element at a time costs O(1) per element.
+ *   Returns FALSE if no argument can be extended.
+ *************************************************************/
+static BOOLEAN _extend_list_block(void *env, core_data_object *val_arr, long argCount, unsigned long seg_size, core_data_object *ret)
+{
+    struct list *orig_ptr, *list;
+    struct list_block *block;
+    struct node *first, *last;
+    long k, pre, post, length, base = -1, baseLength = 0, basePre = 0;
+
+    for( k = 0, pre = 0; k < argCount; pre += length, k++ )
+    {
+        length = core_get_data_ptr_end(val_arr + k) - core_get_data_ptr_start(val_arr + k) + 1;
+
+        if((core_get_pointer_type(val_arr + k) != LIST) || (length <= baseLength))
+        {
+            continue;
+        }
+
+        orig_ptr = (struct list *)core_get_pointer_value(val_arr + k);
+
+        if((block = orig_ptr->block) == NULL )
+        {
+            continue;
+        }
+
+        first = orig_ptr->cell + core_get_data_ptr_start(val_arr + k) - 1;
+        last = orig_ptr->cell + core_get_data_ptr_end(val_arr + k);
+        post = (long)seg_size - pre - length;
+
+        if((pre > 0) && ((first != block->cells + block->front) || (block->front < pre)))
+        {
+            continue;
+        }
+
+        if((post > 0) && ((last != block->cells + block->back) || (block->capacity - block->back < post)))
+        {
+            continue;
+        }
+
+        base = k;
+        baseLength = length;
+        basePre = pre;
+    }
+
+    if( base < 0 )
+    {
+        return(FALSE);
+    }
+
+    orig_ptr = (struct list *)core_get_pointer_value(val_arr + base);
+    block = orig_ptr->block;
+    first = orig_ptr->cell + core_get_data_ptr_start(val_arr + base) - 1;
+    post = (long)seg_size - basePre - baseLength;
+
+    if( basePre > 0 )
+    {
+        _copy_list_args(env, first - basePre, val_arr, 0, base);
+        block->front -= basePre;
+    }
+
+    if( post > 0 )
+    {
+        _copy_list_args(env, first + baseLength, val_arr, base + 1, argCount);
+        block->back += post;
+    }
+
+    list = _create_block_list(env, block, first - basePre, (long)seg_size);
+
+    core_set_pointer_type(ret, LIST);
+    core_set_data_ptr_start(ret, 1);
+    core_set_data_ptr_end(ret, (long)seg_size);
+    core_set_pointer_value(ret, (void *)list);
+    return(TRUE);
+}
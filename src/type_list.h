@@ -6,6 +6,7 @@
 
 struct node;
 struct list;
+struct list_block;
 
 #ifndef __CORE_EVALUATION_H__
 #include "core_evaluation.h"
@@ -17,13 +18,37 @@ struct node
     void *         value;
 };
 
+/*==================================================
+ * A list either owns its cells (fields) or is a
+ * window onto a list_block shared with other lists.
+ * In both cases cell points at the first element.
+ *==================================================*/
 struct list
 {
-    unsigned     busy_count;
-    short        depth;
-    long         length;
-    struct list *next;
-    struct node  cell[1];
+    unsigned           busy_count;
+    short              depth;
+    long               length;
+    struct list *      next;
+    struct list_block *block;
+    struct node *      cell;
+    struct node        fields[1];
+};
+
+/*==================================================
+ * Storage shared by the lists built with cat. Only
+ * cells in [front, back) are in use; they are never
+ * rewritten, so new lists may claim the free cells
+ * on either side without disturbing older ones.
+ * The block holds a reference to every value in
+ * use, released when the last list is freed.
+ *==================================================*/
+struct list_block
+{
+    long        references;
+    long        capacity;
+    long        front;
+    long        back;
+    struct node cells[1];
 };
 
 typedef struct list   LIST_SEGMENT;
@@ -47,7 +72,9 @@ typedef struct node * NODE_PTR;
 
 struct list_data
 {
-    struct list *all_lists;
+    struct list **generations;
+    int           generation_top;
+    int           generation_max;
 };
 
 #define get_list_data(env) ((struct list_data *)core_get_environment_data(env, LIST_DATA_INDEX))
@@ -78,7 +105,8 @@ LOCALE void *        copy_list(void *, struct list *);
 LOCALE BOOLEAN       are_lists_equal(struct list *, struct list *);
 LOCALE void *        convert_data_object_to_list(void *, core_data_object *);
 LOCALE unsigned long hash_list(struct list *, unsigned long);
-LOCALE struct list * get_all_lists(void *);
+LOCALE int           get_list_generation_count(void *);
+LOCALE void          get_list_generation_stats(void *, int, long *, long *);
 LOCALE void *        implode_list(void *, core_data_object *);
 LOCALE void          concatenate_lists(void *, core_data_object *, core_expression_object *, int);
 
@@ -35,13 +35,27 @@
 #define AVERAGE_STRING_SIZE      10
 #define AVERAGE_BITMAP_SIZE      sizeof(long)
 
+#define ATOM_TABLE_REHASH_STEP   4
+
+#define HASH_PRIME_1             0x9E3779B185EBCA87ULL
+#define HASH_PRIME_2             0xC2B2AE3D27D4EB4FULL
+#define HASH_ROTATE(x, r)        (((x) << (r)) | ((x) >> (64 - (r))))
+
 /**************************************
  * LOCAL FUNCTION PROTOTYPES
  ***************************************/
 
-static void                     _remove_hash_node(void *, GENERIC_HN *, GENERIC_HN **, int, int);
-static void                     _add_ephemeron(void *, GENERIC_HN *, struct ephemeron **, int, int);
-static void                     _remove_ephemeron(void *, struct ephemeron **, GENERIC_HN **, int, int, int);
+static void                     _remove_hash_node(void *, GENERIC_HN *, int, int);
+static void                     _add_ephemeron(void *, GENERIC_HN *, struct ephemeron_queue *, int, int);
+static void                     _remove_ephemeron(void *, struct ephemeron_queue *, int, int, int);
+static void                     _init_atom_table(void *, struct atom_table *, unsigned long);
+static GENERIC_HN            ** _atom_table_chain(struct atom_table *, unsigned long long);
+static void                     _add_to_atom_table(void *, struct atom_table *, GENERIC_HN *, GENERIC_HN *, unsigned long long, int);
+static void                     _rehash_atom_table(void *, struct atom_table *, int, unsigned long);
+static unsigned long long       _hash_node(GENERIC_HN *, int);
+static unsigned long long       _mix_hash(unsigned long long);
+static unsigned long long       _float_hash(double);
+static void                     _delete_ephemeron_queue(void *, struct ephemeron_queue *);
 static char                   * _is_string_in_string(char *, char *);
 static size_t                   _common_prefix_length(char *, char *);
 static void                     _delete_symbol_tables(void *);
@@ -64,6 +78,10 @@ void init_symbol_tables(void *env, struct atom_hash_node **symbolTable, struct f
 #pragma unused(externalAddressTable)
 #endif
     unsigned long i;
+#if !IMMEDIATE_NUMBERS
+    long long number;
+    INTEGER_HN *integerPtr;
+#endif
 
     core_allocate_environment_data(env, ATOM_DATA_INDEX, sizeof(struct atom_data), _delete_symbol_tables);
 
@@ -71,14 +89,9 @@ void init_symbol_tables(void *env, struct atom_hash_node **symbolTable, struct f
      * Create the hash tables.
      *=========================*/
 
-    get_atom_data(env)->symbol_table = (ATOM_HN **)
-                                       core_mem_alloc_large_no_init(env, sizeof(ATOM_HN *) * ATOM_HASH_SZ);
-
-    get_atom_data(env)->float_table = (FLOAT_HN **)
-                                      core_mem_alloc_no_init(env, (int)sizeof(FLOAT_HN *) * FLOAT_HASH_SZ);
-
-    get_atom_data(env)->integer_table = (INTEGER_HN **)
-                                        core_mem_alloc_no_init(env, (int)sizeof(INTEGER_HN *) * INTEGER_HASH_SZ);
+    _init_atom_table(env, &get_atom_data(env)->symbol_table, ATOM_HASH_SZ);
+    _init_atom_table(env, &get_atom_data(env)->float_table, FLOAT_HASH_SZ);
+    _init_atom_table(env, &get_atom_data(env)->integer_table, INTEGER_HASH_SZ);
 
     get_atom_data(env)->bitmap_table = (BITMAP_HN **)
                                        core_mem_alloc_no_init(env, (int)sizeof(BITMAP_HN *) * BITMAP_HASH_SZ);
@@ -90,21 +103,6 @@ void init_symbol_tables(void *env, struct atom_hash_node **symbolTable, struct f
      * Initialize all of the hash table entries to NULL.
      *===================================================*/
 
-    for( i = 0; i < ATOM_HASH_SZ; i++ )
-    {
-        get_atom_data(env)->symbol_table[i] = NULL;
-    }
-
-    for( i = 0; i < FLOAT_HASH_SZ; i++ )
-    {
-        get_atom_data(env)->float_table[i] = NULL;
-    }
-
-    for( i = 0; i < INTEGER_HASH_SZ; i++ )
-    {
-        get_atom_data(env)->integer_table[i] = NULL;
-    }
-
     for( i = 0; i < BITMAP_HASH_SZ; i++ )
     {
         get_atom_data(env)->bitmap_table[i] = NULL;
@@ -127,6 +125,17 @@ void init_symbol_tables(void *env, struct atom_hash_node **symbolTable, struct f
     inc_atom_count(get_atom_data(env)->positive_inf_atom);
     get_atom_data(env)->negative_inf_atom = store_atom(env, NEGATIVE_INFINITY_STRING);
     inc_atom_count(get_atom_data(env)->negative_inf_atom);
+
+#if !IMMEDIATE_NUMBERS
+
+    for( number = SMALL_INTEGER_MIN; number <= SMALL_INTEGER_MAX; number++ )
+    {
+        integerPtr = (INTEGER_HN *)store_long(env, number);
+        inc_integer_count(integerPtr);
+        get_atom_data(env)->small_integers[number - SMALL_INTEGER_MIN] = integerPtr;
+    }
+#endif
+
     get_atom_data(env)->zero_atom = store_long(env, 0LL);
     inc_integer_count(get_atom_data(env)->zero_atom);
 }
@@ -137,26 +146,29 @@ void init_symbol_tables(void *env, struct atom_hash_node **symbolTable, struct f
  *************************************************/
 static void _delete_symbol_tables(void *env)
 {
-    int i;
+    unsigned long i;
     ATOM_HN *shPtr, *nextSHPtr;
     INTEGER_HN *ihPtr, *nextIHPtr;
     FLOAT_HN *fhPtr, *nextFHPtr;
     BITMAP_HN *bmhPtr, *nextBMHPtr;
     EXTERNAL_ADDRESS_HN *eahPtr, *nextEAHPtr;
-    struct ephemeron *edPtr, *nextEDPtr;
 
-    if((get_atom_data(env)->symbol_table == NULL) ||
-       (get_atom_data(env)->float_table == NULL) ||
-       (get_atom_data(env)->integer_table == NULL) ||
+    if((get_atom_data(env)->symbol_table.buckets == NULL) ||
+       (get_atom_data(env)->float_table.buckets == NULL) ||
+       (get_atom_data(env)->integer_table.buckets == NULL) ||
        (get_atom_data(env)->bitmap_table == NULL) ||
        (get_atom_data(env)->external_address_table == NULL))
     {
         return;
     }
 
-    for( i = 0; i < ATOM_HASH_SZ; i++ )
+    _rehash_atom_table(env, &get_atom_data(env)->symbol_table, ATOM, get_atom_data(env)->symbol_table.old_size);
+    _rehash_atom_table(env, &get_atom_data(env)->float_table, FLOAT, get_atom_data(env)->float_table.old_size);
+    _rehash_atom_table(env, &get_atom_data(env)->integer_table, INTEGER, get_atom_data(env)->integer_table.old_size);
+
+    for( i = 0; i < get_atom_data(env)->symbol_table.size; i++ )
     {
-        shPtr = get_atom_data(env)->symbol_table[i];
+        shPtr = (ATOM_HN *)get_atom_data(env)->symbol_table.buckets[i];
 
         while( shPtr != NULL )
         {
@@ -164,7 +176,7 @@ static void _delete_symbol_tables(void *env)
 
             if( !shPtr->is_permanent )
             {
-                core_mem_release(env, shPtr->contents, strlen(shPtr->contents) + 1);
+                core_mem_release(env, shPtr->contents, shPtr->length + 1);
                 core_mem_return_struct(env, atom_hash_node, shPtr);
             }
 
@@ -172,9 +184,9 @@ static void _delete_symbol_tables(void *env)
         }
     }
 
-    for( i = 0; i < FLOAT_HASH_SZ; i++ )
+    for( i = 0; i < get_atom_data(env)->float_table.size; i++ )
     {
-        fhPtr = get_atom_data(env)->float_table[i];
+        fhPtr = (FLOAT_HN *)get_atom_data(env)->float_table.buckets[i];
 
         while( fhPtr != NULL )
         {
@@ -189,9 +201,9 @@ static void _delete_symbol_tables(void *env)
         }
     }
 
-    for( i = 0; i < INTEGER_HASH_SZ; i++ )
+    for( i = 0; i < get_atom_data(env)->integer_table.size; i++ )
     {
-        ihPtr = get_atom_data(env)->integer_table[i];
+        ihPtr = (INTEGER_HN *)get_atom_data(env)->integer_table.buckets[i];
 
         while( ihPtr != NULL )
         {
@@ -245,60 +257,21 @@ static void _delete_symbol_tables(void *env)
      * Remove the is_ephemeral symbol structures.
      *=========================================*/
 
-    edPtr = get_atom_data(env)->atom_ephemerons;
-
-    while( edPtr != NULL )
-    {
-        nextEDPtr = edPtr->next;
-        core_mem_return_struct(env, ephemeron, edPtr);
-        edPtr = nextEDPtr;
-    }
-
-    edPtr = get_atom_data(env)->float_ephemerons;
-
-    while( edPtr != NULL )
-    {
-        nextEDPtr = edPtr->next;
-        core_mem_return_struct(env, ephemeron, edPtr);
-        edPtr = nextEDPtr;
-    }
-
-    edPtr = get_atom_data(env)->integer_ephemerons;
-
-    while( edPtr != NULL )
-    {
-        nextEDPtr = edPtr->next;
-        core_mem_return_struct(env, ephemeron, edPtr);
-        edPtr = nextEDPtr;
-    }
-
-    edPtr = get_atom_data(env)->bitmap_ephemerons;
-
-    while( edPtr != NULL )
-    {
-        nextEDPtr = edPtr->next;
-        core_mem_return_struct(env, ephemeron, edPtr);
-        edPtr = nextEDPtr;
-    }
-
-    edPtr = get_atom_data(env)->external_address_ephemerons;
-
-    while( edPtr != NULL )
-    {
-        nextEDPtr = edPtr->next;
-        core_mem_return_struct(env, ephemeron, edPtr);
-        edPtr = nextEDPtr;
-    }
+    _delete_ephemeron_queue(env, &get_atom_data(env)->atom_ephemerons);
+    _delete_ephemeron_queue(env, &get_atom_data(env)->float_ephemerons);
+    _delete_ephemeron_queue(env, &get_atom_data(env)->integer_ephemerons);
+    _delete_ephemeron_queue(env, &get_atom_data(env)->bitmap_ephemerons);
+    _delete_ephemeron_queue(env, &get_atom_data(env)->external_address_ephemerons);
 
     /*================================
      * Remove the symbol hash tables.
      *================================*/
 
-    core_mem_release_sized(env, get_atom_data(env)->symbol_table, sizeof(ATOM_HN *) * ATOM_HASH_SZ);
+    core_mem_release_sized(env, get_atom_data(env)->symbol_table.buckets, sizeof(GENERIC_HN *) * get_atom_data(env)->symbol_table.size);
 
-    core_mem_free(env, get_atom_data(env)->float_table, (int)sizeof(FLOAT_HN *) * FLOAT_HASH_SZ);
+    core_mem_release_sized(env, get_atom_data(env)->float_table.buckets, sizeof(GENERIC_HN *) * get_atom_data(env)->float_table.size);
 
-    core_mem_free(env, get_atom_data(env)->integer_table, (int)sizeof(INTEGER_HN *) * INTEGER_HASH_SZ);
+    core_mem_release_sized(env, get_atom_data(env)->integer_table.buckets, sizeof(GENERIC_HN *) * get_atom_data(env)->integer_table.size);
 
     core_mem_free(env, get_atom_data(env)->bitmap_table, (int)sizeof(BITMAP_HN *) * BITMAP_HASH_SZ);
 
@@ -314,7 +287,7 @@ static void _delete_symbol_tables(void *env)
  *********************************************************************/
 void *store_atom(void *env, char *str)
 {
-    unsigned long tally;
+    unsigned long long hash;
     size_t length;
     ATOM_HN *past = NULL, *peek;
 
@@ -328,18 +301,21 @@ void *store_atom(void *env, char *str)
         exit_router(env, EXIT_FAILURE);
     }
 
-    tally = hash_atom(str, ATOM_HASH_SZ);
-    peek = get_atom_data(env)->symbol_table[tally];
+    length = strlen(str);
+    hash = hash_atom_bytes(str, length);
+    peek = (ATOM_HN *)*_atom_table_chain(&get_atom_data(env)->symbol_table, hash);
 
     /*==================================================
      * Search for the string in the list of entries for
-     * this symbol table location.  If the string is
-     * found, then return the address of the string.
+     * this symbol table location. The stored hash and
+     * length reject most entries without looking at
+     * their contents.
      *==================================================*/
 
     while( peek != NULL )
     {
-        if( strcmp(str, peek->contents) == 0 )
+        if((peek->hash == hash) && (peek->length == length) &&
+           (memcmp(str, peek->contents, length) == 0))
         {
             return((void *)peek);
         }
@@ -355,30 +331,24 @@ void *store_atom(void *env, char *str)
 
     peek = core_mem_get_struct(env, atom_hash_node);
 
-    if( past == NULL )
-    {
-        get_atom_data(env)->symbol_table[tally] = peek;
-    }
-    else
-    {
-        past->next = peek;
-    }
-
-    length = strlen(str) + 1;
-    peek->contents = (char *)core_mem_alloc_no_init(env, length);
-    peek->next = NULL;
-    peek->bucket = tally;
+    peek->contents = (char *)core_mem_alloc_no_init(env, length + 1);
+    peek->hash = hash;
+    peek->length = length;
+    peek->bucket = 0;
     peek->count = 0;
     peek->is_permanent = FALSE;
     sysdep_strcpy(peek->contents, str);
 
+    _add_to_atom_table(env, &get_atom_data(env)->symbol_table, (GENERIC_HN *)peek,
+                       (GENERIC_HN *)past, hash, ATOM);
+
     /*================================================
      * Add the string to the list of is_ephemeral items.
      *================================================*/
 
+    peek->depth = core_get_evaluation_data(env)->eval_depth;
     _add_ephemeron(env, (GENERIC_HN *)peek, &get_atom_data(env)->atom_ephemerons,
                    sizeof(ATOM_HN), AVERAGE_STRING_SIZE);
-    peek->depth = core_get_evaluation_data(env)->eval_depth;
 
     /*===================================
      * Return the address of the symbol.
@@ -393,16 +363,19 @@ void *store_atom(void *env, char *str)
  *****************************************************************/
 ATOM_HN *lookup_atom(void *env, char *str)
 {
-    unsigned long tally;
+    unsigned long long hash;
+    size_t length;
     ATOM_HN *peek;
 
-    tally = hash_atom(str, ATOM_HASH_SZ);
+    length = strlen(str);
+    hash = hash_atom_bytes(str, length);
 
-    for( peek = get_atom_data(env)->symbol_table[tally];
+    for( peek = (ATOM_HN *)*_atom_table_chain(&get_atom_data(env)->symbol_table, hash);
          peek != NULL;
          peek = peek->next )
     {
-        if( strcmp(str, peek->contents) == 0 )
+        if((peek->hash == hash) && (peek->length == length) &&
+           (memcmp(str, peek->contents, length) == 0))
         {
             return(peek);
         }
@@ -419,15 +392,34 @@ ATOM_HN *lookup_atom(void *env, char *str)
  *******************************************************************/
 void *store_double(void *env, double number)
 {
-    unsigned long tally;
+    unsigned long long hash;
     FLOAT_HN *past = NULL, *peek;
 
+#if IMMEDIATE_NUMBERS
+    union
+    {
+        double             fv;
+        unsigned long long bits;
+    } fis;
+
+    /*=============================================
+     * Floats with spare low bits are immediates.
+     *=============================================*/
+
+    fis.fv = number;
+
+    if((number == number) && (number != 0.0) && ((fis.bits & IMMEDIATE_TAG_MASK) == 0))
+    {
+        return((void *)(size_t)(fis.bits | IMMEDIATE_FLOAT_TAG));
+    }
+#endif
+
     /*====================================
      * Get the hash value for the double.
      *====================================*/
 
-    tally = hash_float(number, FLOAT_HASH_SZ);
-    peek = get_atom_data(env)->float_table[tally];
+    hash = _float_hash(number);
+    peek = (FLOAT_HN *)*_atom_table_chain(&get_atom_data(env)->float_table, hash);
 
     /*==================================================
      * Search for the double in the list of entries for
@@ -453,28 +445,21 @@ void *store_double(void *env, double number)
 
     peek = core_mem_get_struct(env, float_hash_node);
 
-    if( past == NULL )
-    {
-        get_atom_data(env)->float_table[tally] = peek;
-    }
-    else
-    {
-        past->next = peek;
-    }
-
     peek->contents = number;
-    peek->next = NULL;
-    peek->bucket = tally;
+    peek->bucket = 0;
     peek->count = 0;
     peek->is_permanent = FALSE;
 
+    _add_to_atom_table(env, &get_atom_data(env)->float_table, (GENERIC_HN *)peek,
+                       (GENERIC_HN *)past, hash, FLOAT);
+
     /*===============================================
      * Add the float to the list of is_ephemeral items.
      *===============================================*/
 
+    peek->depth = core_get_evaluation_data(env)->eval_depth;
     _add_ephemeron(env, (GENERIC_HN *)peek, &get_atom_data(env)->float_ephemerons,
                    sizeof(FLOAT_HN), 0);
-    peek->depth = core_get_evaluation_data(env)->eval_depth;
 
     /*==================================
      * Return the address of the float.
@@ -491,15 +476,33 @@ void *store_double(void *env, double number)
  ***************************************************************/
 void *store_long(void *env, long long number)
 {
-    unsigned long tally;
+    unsigned long long hash;
     INTEGER_HN *past = NULL, *peek;
 
+#if IMMEDIATE_NUMBERS
+
+    if( is_immediate_integer(number))
+    {
+        return(make_immediate_integer(number));
+    }
+#endif
+
+    /*=====================================
+     * Small integers are always present.
+     *=====================================*/
+
+    if((number >= SMALL_INTEGER_MIN) && (number <= SMALL_INTEGER_MAX) &&
+       (get_atom_data(env)->small_integers[number - SMALL_INTEGER_MIN] != NULL))
+    {
+        return((void *)get_atom_data(env)->small_integers[number - SMALL_INTEGER_MIN]);
+    }
+
     /*==================================
      * Get the hash value for the long.
      *==================================*/
 
-    tally = hash_integer(number, INTEGER_HASH_SZ);
-    peek = get_atom_data(env)->integer_table[tally];
+    hash = _mix_hash((unsigned long long)number);
+    peek = (INTEGER_HN *)*_atom_table_chain(&get_atom_data(env)->integer_table, hash);
 
     /*================================================
      * Search for the long in the list of entries for
@@ -525,28 +528,21 @@ void *store_long(void *env, long long number)
 
     peek = core_mem_get_struct(env, integer_hash_node);
 
-    if( past == NULL )
-    {
-        get_atom_data(env)->integer_table[tally] = peek;
-    }
-    else
-    {
-        past->next = peek;
-    }
-
     peek->contents = number;
-    peek->next = NULL;
-    peek->bucket = tally;
+    peek->bucket = 0;
     peek->count = 0;
     peek->is_permanent = FALSE;
 
+    _add_to_atom_table(env, &get_atom_data(env)->integer_table, (GENERIC_HN *)peek,
+                       (GENERIC_HN *)past, hash, INTEGER);
+
     /*=================================================
      * Add the integer to the list of is_ephemeral items.
      *=================================================*/
 
+    peek->depth = core_get_evaluation_data(env)->eval_depth;
     _add_ephemeron(env, (GENERIC_HN *)peek, &get_atom_data(env)->integer_ephemerons,
                    sizeof(INTEGER_HN), 0);
-    peek->depth = core_get_evaluation_data(env)->eval_depth;
 
     /*====================================
      * Return the address of the integer.
@@ -561,12 +557,17 @@ void *store_long(void *env, long long number)
  *****************************************************************/
 INTEGER_HN *lookup_long(void *env, long long theLong)
 {
-    unsigned long tally;
     INTEGER_HN *peek;
 
-    tally = hash_integer(theLong, INTEGER_HASH_SZ);
+#if IMMEDIATE_NUMBERS
 
-    for( peek = get_atom_data(env)->integer_table[tally];
+    if( is_immediate_integer(theLong))
+    {
+        return((INTEGER_HN *)make_immediate_integer(theLong));
+    }
+#endif
+
+    for( peek = (INTEGER_HN *)*_atom_table_chain(&get_atom_data(env)->integer_table, _mix_hash((unsigned long long)theLong));
          peek != NULL;
          peek = peek->next )
     {
@@ -579,6 +580,26 @@ INTEGER_HN *lookup_long(void *env, long long theLong)
     return(NULL);
 }
 
+#if IMMEDIATE_NUMBERS
+
+/*************************************************
+ * immediate_to_double: Returns the double held
+ *   in the bits of an immediate float.
+ **************************************************/
+double immediate_to_double(void *value)
+{
+    union
+    {
+        double             fv;
+        unsigned long long bits;
+    } fis;
+
+    fis.bits = immediate_bits(value) & ~IMMEDIATE_TAG_MASK;
+    return(fis.fv);
+}
+
+#endif
+
 /******************************************************************
  * store_bitmap: Searches for the bitmap in the hash table. If the
  *   bitmap is already in the hash table, then the address of the
@@ -665,9 +686,9 @@ void *store_bitmap(void *env, void *vTheBitMap, unsigned size)
      * Add the bitmap to the list of is_ephemeral items.
      *================================================*/
 
+    peek->depth = core_get_evaluation_data(env)->eval_depth;
     _add_ephemeron(env, (GENERIC_HN *)peek, &get_atom_data(env)->bitmap_ephemerons,
                    sizeof(BITMAP_HN), sizeof(long));
-    peek->depth = core_get_evaluation_data(env)->eval_depth;
 
     /*===================================
      * Return the address of the bitmap.
@@ -741,9 +762,9 @@ void *store_external_address(void *env, void *theExternalAddress, unsigned theTy
      * Add the bitmap to the list of is_ephemeral items.
      *================================================*/
 
+    peek->depth = core_get_evaluation_data(env)->eval_depth;
     _add_ephemeron(env, (GENERIC_HN *)peek, &get_atom_data(env)->external_address_ephemerons,
                    sizeof(EXTERNAL_ADDRESS_HN), sizeof(long));
-    peek->depth = core_get_evaluation_data(env)->eval_depth;
 
     /*=============================================
      * Return the address of the external address.
@@ -773,6 +794,69 @@ unsigned long hash_atom(char *word, unsigned long range)
     return(tally % range);
 }
 
+/****************************************************
+ * hash_atom_bytes: Computes the 64 bit hash used by
+ *   the symbol table. The string is consumed eight
+ *   bytes at a time and the result is run through
+ *   a final mix so that every bit of the input
+ *   affects the low bits used to pick a bucket.
+ *****************************************************/
+unsigned long long hash_atom_bytes(char *word, size_t length)
+{
+    unsigned long long tally, chunk;
+
+    tally = ((unsigned long long)length) * HASH_PRIME_1;
+
+    while( length >= sizeof(unsigned long long))
+    {
+        memcpy(&chunk, word, sizeof(unsigned long long));
+        chunk *= HASH_PRIME_2;
+        tally ^= HASH_ROTATE(chunk, 31) * HASH_PRIME_1;
+        tally = HASH_ROTATE(tally, 27) * HASH_PRIME_1 + HASH_PRIME_2;
+        word += sizeof(unsigned long long);
+        length -= sizeof(unsigned long long);
+    }
+
+    chunk = 0;
+    memcpy(&chunk, word, length);
+    chunk *= HASH_PRIME_2;
+    tally ^= HASH_ROTATE(chunk, 31) * HASH_PRIME_1;
+
+    return(_mix_hash(tally));
+}
+
+/************************************************
+ * _mix_hash: Scrambles the bits of a 64 bit
+ *   value. Used directly for integers and as
+ *   the final step of the other hashes.
+ *************************************************/
+static unsigned long long _mix_hash(unsigned long long tally)
+{
+    tally ^= tally >> 33;
+    tally *= 0xFF51AFD7ED558CCDULL;
+    tally ^= tally >> 33;
+    tally *= 0xC4CEB9FE1A85EC53ULL;
+    tally ^= tally >> 33;
+
+    return(tally);
+}
+
+/************************************************
+ * _float_hash: Computes the 64 bit hash used by
+ *   the float table from the bits of a double.
+ *************************************************/
+static unsigned long long _float_hash(double number)
+{
+    union
+    {
+        double             fv;
+        unsigned long long bits;
+    } fis;
+
+    fis.fv = number;
+    return(_mix_hash(fis.bits));
+}
+
 /************************************************
  * hash_float: Computes a hash value for a float.
  *************************************************/
@@ -943,6 +1027,14 @@ void dec_atom_count(void *env, ATOM_HN *val)
  ***************************************************/
 void dec_float_count(void *env, FLOAT_HN *val)
 {
+#if IMMEDIATE_NUMBERS
+
+    if( is_immediate(val))
+    {
+        return;
+    }
+#endif
+
     if( val->count <= 0 )
     {
         error_system(env, "ATOM", 5);
@@ -972,6 +1064,14 @@ void dec_float_count(void *env, FLOAT_HN *val)
  *********************************************************/
 void dec_integer_count(void *env, INTEGER_HN *val)
 {
+#if IMMEDIATE_NUMBERS
+
+    if( is_immediate(val))
+    {
+        return;
+    }
+#endif
+
     if( val->count <= 0 )
     {
         error_system(env, "ATOM", 6);
@@ -1064,22 +1164,188 @@ void dec_external_address_count(void *env, EXTERNAL_ADDRESS_HN *val)
     return;
 }
 
+/***********************************************
+ * _init_atom_table: Allocates the bucket array
+ *   of a symbol, float or integer table.
+ ************************************************/
+static void _init_atom_table(void *env, struct atom_table *table, unsigned long size)
+{
+    unsigned long i;
+
+    table->buckets = (GENERIC_HN **)core_mem_alloc_large_no_init(env, sizeof(GENERIC_HN *) * size);
+    table->size = size;
+    table->count = 0;
+    table->old_buckets = NULL;
+    table->old_size = 0;
+    table->migrated = 0;
+
+    for( i = 0; i < size; i++ )
+    {
+        table->buckets[i] = NULL;
+    }
+}
+
+/**************************************************
+ * _atom_table_chain: Returns the bucket holding
+ *   the entries with the specified hash. This is
+ *   the old bucket if it has not been moved yet.
+ ***************************************************/
+static GENERIC_HN **_atom_table_chain(struct atom_table *table, unsigned long long hash)
+{
+    unsigned long index;
+
+    if( table->old_buckets != NULL )
+    {
+        index = (unsigned long)(hash & (table->old_size - 1));
+
+        if( index >= table->migrated )
+        {
+            return(&table->old_buckets[index]);
+        }
+    }
+
+    return(&table->buckets[hash & (table->size - 1)]);
+}
+
+/****************************************************
+ * _add_to_atom_table: Links a new entry after the
+ *   last entry found while searching its bucket,
+ *   then advances any rehash in progress or starts
+ *   one if the table has filled up.
+ *****************************************************/
+static void _add_to_atom_table(void *env, struct atom_table *table, GENERIC_HN *node, GENERIC_HN *past, unsigned long long hash, int type)
+{
+    node->next = NULL;
+
+    if( past == NULL )
+    {
+        *_atom_table_chain(table, hash) = node;
+    }
+    else
+    {
+        past->next = node;
+    }
+
+    table->count++;
+
+    if( table->old_buckets != NULL )
+    {
+        _rehash_atom_table(env, table, type, ATOM_TABLE_REHASH_STEP);
+    }
+    else if( table->count > table->size )
+    {
+        table->old_buckets = table->buckets;
+        table->old_size = table->size;
+        table->migrated = 0;
+
+        table->size *= 2;
+        table->buckets = (GENERIC_HN **)core_mem_alloc_large_no_init(env, sizeof(GENERIC_HN *) * table->size);
+        memset(table->buckets, 0, sizeof(GENERIC_HN *) * table->size);
+    }
+}
+
+/*****************************************************
+ * _rehash_atom_table: Moves up to the specified number
+ *   of old buckets into the new bucket array. The old
+ *   array is released once all of it has been moved.
+ ******************************************************/
+static void _rehash_atom_table(void *env, struct atom_table *table, int type, unsigned long steps)
+{
+    GENERIC_HN *node, *nextNode, **chain;
+
+    if( table->old_buckets == NULL )
+    {
+        return;
+    }
+
+    while((steps > 0) && (table->migrated < table->old_size))
+    {
+        node = table->old_buckets[table->migrated];
+        table->old_buckets[table->migrated] = NULL;
+        table->migrated++;
+
+        while( node != NULL )
+        {
+            nextNode = node->next;
+            chain = &table->buckets[_hash_node(node, type) & (table->size - 1)];
+            node->next = *chain;
+            *chain = node;
+            node = nextNode;
+        }
+
+        steps--;
+    }
+
+    if( table->migrated >= table->old_size )
+    {
+        core_mem_release_sized(env, table->old_buckets, sizeof(GENERIC_HN *) * table->old_size);
+        table->old_buckets = NULL;
+        table->old_size = 0;
+        table->migrated = 0;
+    }
+}
+
+/*************************************************
+ * _hash_node: Returns the 64 bit hash of a node
+ *   in the symbol, float or integer table.
+ **************************************************/
+static unsigned long long _hash_node(GENERIC_HN *node, int type)
+{
+    switch( type )
+    {
+    case ATOM:
+        return(((ATOM_HN *)node)->hash);
+
+    case FLOAT:
+        return(_float_hash(((FLOAT_HN *)node)->contents));
+
+    default:
+        return(_mix_hash((unsigned long long)((INTEGER_HN *)node)->contents));
+    }
+}
+
 /***********************************************
  * RemoveHashNode: Removes a hash node from the
  *   symbol_table, float_table, integer_table,
  *   bitmap_table, or external_address_table.
  ************************************************/
-static void _remove_hash_node(void *env, GENERIC_HN *val, GENERIC_HN **theTable, int size, int type)
+static void _remove_hash_node(void *env, GENERIC_HN *val, int size, int type)
 {
-    GENERIC_HN *previousNode, *currentNode;
+    GENERIC_HN *previousNode, *currentNode, **chain;
     struct external_address_hash_node *theAddress;
 
     /*=============================================
      * Find the entry in the specified hash table.
      *=============================================*/
 
+    switch( type )
+    {
+    case ATOM:
+        chain = _atom_table_chain(&get_atom_data(env)->symbol_table, _hash_node(val, type));
+        get_atom_data(env)->symbol_table.count--;
+        break;
+
+    case FLOAT:
+        chain = _atom_table_chain(&get_atom_data(env)->float_table, _hash_node(val, type));
+        get_atom_data(env)->float_table.count--;
+        break;
+
+    case INTEGER:
+        chain = _atom_table_chain(&get_atom_data(env)->integer_table, _hash_node(val, type));
+        get_atom_data(env)->integer_table.count--;
+        break;
+
+    case BITMAPARRAY:
+        chain = (GENERIC_HN **)&get_atom_data(env)->bitmap_table[val->bucket];
+        break;
+
+    default:
+        chain = (GENERIC_HN **)&get_atom_data(env)->external_address_table[val->bucket];
+        break;
+    }
+
     previousNode = NULL;
-    currentNode = theTable[val->bucket];
+    currentNode = *chain;
 
     while( currentNode != val )
     {
@@ -1100,7 +1366,7 @@ static void _remove_hash_node(void *env, GENERIC_HN *val, GENERIC_HN **theTable,
 
     if( previousNode == NULL )
     {
-        theTable[val->bucket] = val->next;
+        *chain = val->next;
     }
     else
     {
@@ -1115,7 +1381,7 @@ static void _remove_hash_node(void *env, GENERIC_HN *val, GENERIC_HN **theTable,
     if( type == ATOM )
     {
         core_mem_release(env, ((ATOM_HN *)val)->contents,
-                         strlen(((ATOM_HN *)val)->contents) + 1);
+                         ((ATOM_HN *)val)->length + 1);
     }
     else if( type == BITMAPARRAY )
     {
@@ -1147,9 +1413,10 @@ static void _remove_hash_node(void *env, GENERIC_HN *val, GENERIC_HN **theTable,
  *   values. These entries have a zero count indicating
  *   that no structure is using the data value.
  ***********************************************************/
-static void _add_ephemeron(void *env, GENERIC_HN *theHashNode, struct ephemeron **theEphemeralList, int hashNodeSize, int averageContentsSize)
+static void _add_ephemeron(void *env, GENERIC_HN *theHashNode, struct ephemeron_queue *theQueue, int hashNodeSize, int averageContentsSize)
 {
     struct ephemeron *temp;
+    int depth, newMax, i;
 
     /*===========================================
      * If the count isn't zero then this routine
@@ -1170,13 +1437,41 @@ static void _add_ephemeron(void *env, GENERIC_HN *theHashNode, struct ephemeron
 
     /*=============================
      * Add the atomic value to the
-     * list of is_ephemeral values.
+     * bucket for its depth.
      *=============================*/
 
+    depth = (theHashNode->depth < 0) ? 0 : theHashNode->depth;
+
+    if( depth >= theQueue->max )
+    {
+        newMax = (theQueue->max == 0) ? 16 : theQueue->max;
+
+        while( newMax <= depth )
+        {
+            newMax *= 2;
+        }
+
+        theQueue->buckets = (struct ephemeron **)
+                            core_mem_realloc(env, theQueue->buckets, sizeof(struct ephemeron *) * theQueue->max,
+                                             sizeof(struct ephemeron *) * newMax);
+
+        for( i = theQueue->max; i < newMax; i++ )
+        {
+            theQueue->buckets[i] = NULL;
+        }
+
+        theQueue->max = newMax;
+    }
+
     temp = core_mem_get_struct(env, ephemeron);
     temp->its_value = theHashNode;
-    temp->next = *theEphemeralList;
-    *theEphemeralList = temp;
+    temp->next = theQueue->buckets[depth];
+    theQueue->buckets[depth] = temp;
+
+    if( depth >= theQueue->top )
+    {
+        theQueue->top = depth + 1;
+    }
 
     /*=========================================================
      * Increment the is_ephemeral count and size variables. These
@@ -1197,123 +1492,143 @@ static void _add_ephemeron(void *env, GENERIC_HN *theHashNode, struct ephemeron
  ***************************************************/
 void remove_ephemeral_atoms(void *env)
 {
-    _remove_ephemeron(env, &get_atom_data(env)->atom_ephemerons, (GENERIC_HN **)get_atom_data(env)->symbol_table,
+    _remove_ephemeron(env, &get_atom_data(env)->atom_ephemerons,
                       sizeof(ATOM_HN), ATOM, AVERAGE_STRING_SIZE);
-    _remove_ephemeron(env, &get_atom_data(env)->float_ephemerons, (GENERIC_HN **)get_atom_data(env)->float_table,
+    _remove_ephemeron(env, &get_atom_data(env)->float_ephemerons,
                       sizeof(FLOAT_HN), FLOAT, 0);
-    _remove_ephemeron(env, &get_atom_data(env)->integer_ephemerons, (GENERIC_HN **)get_atom_data(env)->integer_table,
+    _remove_ephemeron(env, &get_atom_data(env)->integer_ephemerons,
                       sizeof(INTEGER_HN), INTEGER, 0);
-    _remove_ephemeron(env, &get_atom_data(env)->bitmap_ephemerons, (GENERIC_HN **)get_atom_data(env)->bitmap_table,
+    _remove_ephemeron(env, &get_atom_data(env)->bitmap_ephemerons,
                       sizeof(BITMAP_HN), BITMAPARRAY, AVERAGE_BITMAP_SIZE);
-    _remove_ephemeron(env, &get_atom_data(env)->external_address_ephemerons, (GENERIC_HN **)get_atom_data(env)->external_address_table,
+    _remove_ephemeron(env, &get_atom_data(env)->external_address_ephemerons,
                       sizeof(EXTERNAL_ADDRESS_HN), EXTERNAL_ADDRESS, 0);
 }
 
 /***************************************************************
  * RemoveEphemeralHashNodes: Removes symbols from the is_ephemeral
- *   symbol list that have a count of zero and were placed on
- *   the list at a higher level than the current evaluation
- *   depth. Since symbols are ordered in the list in descending
- *   order, the removal process can end when a depth is reached
- *   less than the current evaluation depth. Because is_ephemeral
- *   symbols can be "pulled" up through an evaluation depth,
- *   this routine needs to check through both the previous and
- *   current evaluation depth.
+ *   symbol queue that have a count of zero and were placed on
+ *   the queue at a higher level than the current evaluation
+ *   depth. Only the buckets deeper than the current depth are
+ *   visited. Because is_ephemeral symbols can be "pulled" up
+ *   through an evaluation depth, a symbol found in a bucket
+ *   deeper than its own depth is moved down to that bucket.
  ****************************************************************/
-static void _remove_ephemeron(void *env, struct ephemeron **theEphemeralList, GENERIC_HN **theTable, int hashNodeSize, int hashNodeType, int averageContentsSize)
+static void _remove_ephemeron(void *env, struct ephemeron_queue *theQueue, int hashNodeSize, int hashNodeType, int averageContentsSize)
 {
-    struct ephemeron *edPtr, *lastPtr = NULL, *nextPtr;
+    struct ephemeron *edPtr, *nextPtr;
+    int bucket, depth, target;
 
-    edPtr = *theEphemeralList;
+    depth = core_get_evaluation_data(env)->eval_depth;
 
-    while( edPtr != NULL )
+    for( bucket = theQueue->top - 1; bucket > depth; bucket-- )
     {
-        /*======================================================
-         * Check through previous and current evaluation depth
-         * because these symbols can be interspersed, otherwise
-         * symbols are stored in descending evaluation depth.
-         *======================================================*/
-
-        nextPtr = edPtr->next;
-
-        /*==================================================
-         * Remove any symbols that have a count of zero and
-         * were added to the is_ephemeral list at a higher
-         * evaluation depth.
-         *==================================================*/
+        edPtr = theQueue->buckets[bucket];
+        theQueue->buckets[bucket] = NULL;
 
-        if((edPtr->its_value->count == 0) &&
-           (edPtr->its_value->depth > core_get_evaluation_data(env)->eval_depth))
+        while( edPtr != NULL )
         {
-            _remove_hash_node(env, edPtr->its_value, theTable, hashNodeSize, hashNodeType);
-            core_mem_return_struct(env, ephemeron, edPtr);
+            nextPtr = edPtr->next;
 
-            if( lastPtr == NULL )
-            {
-                *theEphemeralList = nextPtr;
-            }
-            else
+            /*==================================================
+             * Remove any symbols that have a count of zero and
+             * were added to the is_ephemeral list at a higher
+             * evaluation depth.
+             *==================================================*/
+
+            if((edPtr->its_value->count == 0) && (edPtr->its_value->depth > depth))
             {
-                lastPtr->next = nextPtr;
+                _remove_hash_node(env, edPtr->its_value, hashNodeSize, hashNodeType);
+                core_mem_return_struct(env, ephemeron, edPtr);
+
+                core_get_gc_data(env)->generational_item_count--;
+                core_get_gc_data(env)->generational_item_sz -= sizeof(struct ephemeron) + hashNodeSize +
+                                                               averageContentsSize;
             }
 
-            core_get_gc_data(env)->generational_item_count--;
-            core_get_gc_data(env)->generational_item_sz -= sizeof(struct ephemeron) + hashNodeSize +
-                                                           averageContentsSize;
-        }
+            /*=======================================
+             * Remove is_ephemeral status of any symbol
+             * with a count greater than zero.
+             *=======================================*/
 
-        /*=======================================
-         * Remove is_ephemeral status of any symbol
-         * with a count greater than zero.
-         *=======================================*/
+            else if( edPtr->its_value->count > 0 )
+            {
+                edPtr->its_value->is_ephemeral = FALSE;
+                core_mem_return_struct(env, ephemeron, edPtr);
 
-        else if( edPtr->its_value->count > 0 )
-        {
-            edPtr->its_value->is_ephemeral = FALSE;
+                core_get_gc_data(env)->generational_item_count--;
+                core_get_gc_data(env)->generational_item_sz -= sizeof(struct ephemeron) + hashNodeSize +
+                                                               averageContentsSize;
+            }
 
-            core_mem_return_struct(env, ephemeron, edPtr);
+            /*==================================================
+             * Otherwise keep the symbol in the bucket for the
+             * depth it was pulled up to.
+             *==================================================*/
 
-            if( lastPtr == NULL )
-            {
-                *theEphemeralList = nextPtr;
-            }
             else
             {
-                lastPtr->next = nextPtr;
+                target = (edPtr->its_value->depth < 0) ? 0 : edPtr->its_value->depth;
+                edPtr->next = theQueue->buckets[target];
+                theQueue->buckets[target] = edPtr;
             }
 
-            core_get_gc_data(env)->generational_item_count--;
-            core_get_gc_data(env)->generational_item_sz -= sizeof(struct ephemeron) + hashNodeSize +
-                                                           averageContentsSize;
+            edPtr = nextPtr;
         }
+    }
 
-        /*==================================================
-         * Otherwise keep the symbol in the is_ephemeral list.
-         *==================================================*/
+    while((theQueue->top > 0) && (theQueue->buckets[theQueue->top - 1] == NULL))
+    {
+        theQueue->top--;
+    }
+}
 
-        else
+/***************************************************************
+ * _delete_ephemeron_queue: Returns the ephemerons in a queue
+ *   and the queue's bucket array to the memory pool.
+ ****************************************************************/
+static void _delete_ephemeron_queue(void *env, struct ephemeron_queue *theQueue)
+{
+    struct ephemeron *edPtr, *nextEDPtr;
+    int i;
+
+    for( i = 0; i < theQueue->top; i++ )
+    {
+        edPtr = theQueue->buckets[i];
+
+        while( edPtr != NULL )
         {
-            lastPtr = edPtr;
+            nextEDPtr = edPtr->next;
+            core_mem_return_struct(env, ephemeron, edPtr);
+            edPtr = nextEDPtr;
         }
+    }
 
-        edPtr = nextPtr;
+    if( theQueue->max > 0 )
+    {
+        core_mem_free(env, theQueue->buckets, sizeof(struct ephemeron *) * theQueue->max);
     }
 }
 
-/********************************************************
- * get_symbol_table: Returns a pointer to the symbol_table.
- *********************************************************/
+/*************************************************************
+ * get_symbol_table: Returns a pointer to the symbol_table's
+ *   buckets. Any rehash in progress is finished first so that
+ *   every symbol can be reached from the returned array.
+ **************************************************************/
 ATOM_HN **get_symbol_table(void *env)
 {
-    return(get_atom_data(env)->symbol_table);
+    struct atom_table *table = &get_atom_data(env)->symbol_table;
+
+    _rehash_atom_table(env, table, ATOM, table->old_size);
+    return((ATOM_HN **)table->buckets);
 }
 
-/*****************************************************
- * set_symbol_table: Sets the value of the symbol_table.
- ******************************************************/
-void set_symbol_table(void *env, ATOM_HN **value)
+/***********************************************************
+ * get_symbol_table_size: Returns the number of buckets in
+ *   the array returned by get_symbol_table.
+ ************************************************************/
+unsigned long get_symbol_table_size(void *env)
 {
-    get_atom_data(env)->symbol_table = value;
+    return(get_atom_data(env)->symbol_table.size);
 }
 
 /******************************************************
@@ -1321,15 +1636,19 @@ void set_symbol_table(void *env, ATOM_HN **value)
  *******************************************************/
 FLOAT_HN **get_float_table(void *env)
 {
-    return(get_atom_data(env)->float_table);
+    struct atom_table *table = &get_atom_data(env)->float_table;
+
+    _rehash_atom_table(env, table, FLOAT, table->old_size);
+    return((FLOAT_HN **)table->buckets);
 }
 
-/***************************************************
- * set_float_table: Sets the value of the float_table.
- ****************************************************/
-void set_float_table(void *env, FLOAT_HN **value)
+/***********************************************************
+ * get_float_table_size: Returns the number of buckets in
+ *   the array returned by get_float_table.
+ ************************************************************/
+unsigned long get_float_table_size(void *env)
 {
-    get_atom_data(env)->float_table = value;
+    return(get_atom_data(env)->float_table.size);
 }
 
 /**********************************************************
@@ -1337,15 +1656,19 @@ void set_float_table(void *env, FLOAT_HN **value)
  ***********************************************************/
 INTEGER_HN **get_integer_table(void *env)
 {
-    return(get_atom_data(env)->integer_table);
+    struct atom_table *table = &get_atom_data(env)->integer_table;
+
+    _rehash_atom_table(env, table, INTEGER, table->old_size);
+    return((INTEGER_HN **)table->buckets);
 }
 
-/*******************************************************
- * set_integer_table: Sets the value of the integer_table.
- ********************************************************/
-void set_integer_table(void *env, INTEGER_HN **value)
+/***********************************************************
+ * get_integer_table_size: Returns the number of buckets in
+ *   the array returned by get_integer_table.
+ ************************************************************/
+unsigned long get_integer_table_size(void *env)
 {
-    get_atom_data(env)->integer_table = value;
+    return(get_atom_data(env)->integer_table.size);
 }
 
 /********************************************************
@@ -1460,7 +1783,8 @@ void init_bitmap(void *vTheBitMap, unsigned length)
 ATOM_HN *next_atom_match(void *env, char *searchString, size_t searchLength, ATOM_HN *prevSymbol, int anywhere, size_t *commonPrefixLength)
 {
     register unsigned long i;
-    ATOM_HN *hashPtr;
+    unsigned long tableSize;
+    ATOM_HN **symbolArray, *hashPtr;
     int flag = TRUE;
     size_t prefixLength;
 
@@ -1479,10 +1803,13 @@ ATOM_HN *next_atom_match(void *env, char *searchString, size_t searchLength, ATO
      * symbol table, the previous symbol argument is NULL.
      *========================================================*/
 
+    symbolArray = get_symbol_table(env);
+    tableSize = get_symbol_table_size(env);
+
     if( prevSymbol == NULL )
     {
         i = 0;
-        hashPtr = get_atom_data(env)->symbol_table[0];
+        hashPtr = symbolArray[0];
     }
 
     /*==========================================
@@ -1492,7 +1819,7 @@ ATOM_HN *next_atom_match(void *env, char *searchString, size_t searchLength, ATO
 
     else
     {
-        i = prevSymbol->bucket;
+        i = (unsigned long)(prevSymbol->hash & (tableSize - 1));
         hashPtr = prevSymbol->next;
     }
 
@@ -1586,13 +1913,13 @@ ATOM_HN *next_atom_match(void *env, char *searchString, size_t searchLength, ATO
          * Move on to the next bucket in the symbol table.
          *=================================================*/
 
-        if( ++i >= ATOM_HASH_SZ )
+        if( ++i >= tableSize )
         {
             flag = FALSE;
         }
         else
         {
-            hashPtr = get_atom_data(env)->symbol_table[i];
+            hashPtr = symbolArray[i];
         }
     }
 
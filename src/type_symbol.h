@@ -19,16 +19,26 @@
 
 #include <stdlib.h>
 
+#ifndef _H_setup
+#include "setup.h"
+#endif
+
+/*==================================================
+ * Initial sizes of the symbol, float and integer
+ * tables. These must be powers of two; the tables
+ * double whenever they hold as many entries as they
+ * have buckets.
+ *==================================================*/
 #ifndef ATOM_HASH_SZ
-#define ATOM_HASH_SZ       63559L
+#define ATOM_HASH_SZ       16384L
 #endif
 
 #ifndef FLOAT_HASH_SZ
-#define FLOAT_HASH_SZ         8191
+#define FLOAT_HASH_SZ         1024
 #endif
 
 #ifndef INTEGER_HASH_SZ
-#define INTEGER_HASH_SZ       8191
+#define INTEGER_HASH_SZ       1024
 #endif
 
 #ifndef BITMAP_HASH_SZ
@@ -55,6 +65,8 @@ struct atom_hash_node
     1;
     unsigned int bucket :
     29;
+    unsigned long long hash;
+    size_t             length;
     char *contents;
 };
 
@@ -161,6 +173,24 @@ typedef struct bitmap_hash_node           BITMAP_HN;
 typedef struct external_address_hash_node EXTERNAL_ADDRESS_HN;
 typedef struct generic_hash_node          GENERIC_HN;
 
+/*********************************************************
+ * ATOM TABLE STRUCTURE: A power of two hash table for
+ *   symbols, floats or integers. When the table grows,
+ *   the old bucket array is kept and its buckets are
+ *   moved over a few at a time by later insertions. An
+ *   entry lives in the old array if its old bucket has
+ *   not been moved yet, and in the new array otherwise.
+ **********************************************************/
+struct atom_table
+{
+    GENERIC_HN **  buckets;
+    unsigned long  size;
+    unsigned long  count;
+    GENERIC_HN **  old_buckets;
+    unsigned long  old_size;
+    unsigned long  migrated;
+};
+
 /*********************************************************
  * EPHEMERON STRUCTURE: Data structure used to keep track
  *   of is_ephemeral symbols, floats, and integers.
@@ -178,6 +208,27 @@ struct ephemeron
     struct ephemeron *next;
 };
 
+/*********************************************************
+ * EPHEMERON QUEUE STRUCTURE: The ephemerons of one kind
+ *   of atomic value, kept in one bucket per evaluation
+ *   depth so that a cleanup only visits the buckets
+ *   deeper than the current depth.
+ **********************************************************/
+struct ephemeron_queue
+{
+    struct ephemeron **buckets;
+    int                top;
+    int                max;
+};
+
+/*********************************************************
+ * Integers in this range are created once, made
+ * permanent, and returned by store_long without a
+ * hash table search.
+ **********************************************************/
+#define SMALL_INTEGER_MIN -128LL
+#define SMALL_INTEGER_MAX 1023LL
+
 /***********************************************************
  * atom_match STRUCTURE:
  ************************************************************/
@@ -187,16 +238,53 @@ struct atom_match
     struct atom_match     *next;
 };
 
-#define to_string(target)           (((struct atom_hash_node *)(target))->contents)
+/*********************************************************
+ * IMMEDIATE NUMBERS: An integer that fits in 61 bits is
+ *   kept in the value pointer itself, shifted left past a
+ *   three bit tag. A float whose low three mantissa bits
+ *   are clear is kept as its bit pattern with the tag in
+ *   those bits. Zeros and NaNs always go to the float
+ *   table so that their comparisons behave as before.
+ *   Immediates have no count and are never collected.
+ **********************************************************/
+#if IMMEDIATE_NUMBERS
+
+#define IMMEDIATE_TAG_MASK     0x7ULL
+#define IMMEDIATE_INTEGER_TAG  0x1ULL
+#define IMMEDIATE_FLOAT_TAG    0x2ULL
+#define IMMEDIATE_INTEGER_MIN  (-(1LL << 60))
+#define IMMEDIATE_INTEGER_MAX  ((1LL << 60) - 1)
+
+#define immediate_bits(target)      ((unsigned long long)(size_t)(target))
+#define is_immediate(target)        ((immediate_bits(target) & IMMEDIATE_TAG_MASK) != 0)
+#define is_immediate_integer(number) (((number) >= IMMEDIATE_INTEGER_MIN) && ((number) <= IMMEDIATE_INTEGER_MAX))
+#define make_immediate_integer(number) ((void *)(size_t)((((unsigned long long)(number)) << 3) | IMMEDIATE_INTEGER_TAG))
+#define immediate_to_long(target)   (((long long)immediate_bits(target)) >> 3)
+
+#define to_double(target)           ((is_immediate(target)) ? immediate_to_double(target) : ((struct float_hash_node *)(target))->contents)
+#define to_long(target)             ((is_immediate(target)) ? immediate_to_long(target) : ((struct integer_hash_node *)(target))->contents)
+
+#define inc_float_count(val)            ((is_immediate(val)) ? 0L : ((FLOAT_HN *)val)->count++)
+#define inc_integer_count(val)          ((is_immediate(val)) ? 0L : ((INTEGER_HN *)val)->count++)
+
+#else
+
+#define is_immediate(target)        FALSE
+
 #define to_double(target)           (((struct float_hash_node *)(target))->contents)
 #define to_long(target)             (((struct integer_hash_node *)(target))->contents)
-#define to_int(target)              ((int)(((struct integer_hash_node *)(target))->contents))
+
+#define inc_float_count(val)            (((FLOAT_HN *)val)->count++)
+#define inc_integer_count(val)          (((INTEGER_HN *)val)->count++)
+
+#endif
+
+#define to_string(target)           (((struct atom_hash_node *)(target))->contents)
+#define to_int(target)              ((int)to_long(target))
 #define to_bitmap(target)           ((void *)((struct bitmap_hash_node *)(target))->contents)
 #define to_external_address(target) ((void *)((struct external_address_hash_node *)(target))->address)
 
 #define inc_atom_count(val)             (((ATOM_HN *)val)->count++)
-#define inc_float_count(val)            (((FLOAT_HN *)val)->count++)
-#define inc_integer_count(val)          (((INTEGER_HN *)val)->count++)
 #define inc_bitmap_count(val)           (((BITMAP_HN *)val)->count++)
 #define inc_external_address_count(val) (((EXTERNAL_ADDRESS_HN *)val)->count++)
 
@@ -213,16 +301,17 @@ struct atom_data
     void *                positive_inf_atom;
     void *                negative_inf_atom;
     void *                zero_atom;
-    ATOM_HN **            symbol_table;
-    FLOAT_HN **           float_table;
-    INTEGER_HN **         integer_table;
+    struct atom_table     symbol_table;
+    struct atom_table     float_table;
+    struct atom_table     integer_table;
     BITMAP_HN **          bitmap_table;
     EXTERNAL_ADDRESS_HN **external_address_table;
-    struct ephemeron *    atom_ephemerons;
-    struct ephemeron *    float_ephemerons;
-    struct ephemeron *    integer_ephemerons;
-    struct ephemeron *    bitmap_ephemerons;
-    struct ephemeron *    external_address_ephemerons;
+    struct ephemeron_queue atom_ephemerons;
+    struct ephemeron_queue float_ephemerons;
+    struct ephemeron_queue integer_ephemerons;
+    struct ephemeron_queue bitmap_ephemerons;
+    struct ephemeron_queue external_address_ephemerons;
+    INTEGER_HN *          small_integers[SMALL_INTEGER_MAX - SMALL_INTEGER_MIN + 1];
 };
 
 #define get_atom_data(env)     ((struct atom_data *)core_get_environment_data(env, ATOM_DATA_INDEX))
@@ -238,7 +327,11 @@ LOCALE void                          *    store_long(void *, long long);
 LOCALE void                          *    store_bitmap(void *, void *, unsigned);
 LOCALE void                          *    store_external_address(void *, void *, unsigned);
 LOCALE INTEGER_HN                    *    lookup_long(void *, long long);
+#if IMMEDIATE_NUMBERS
+LOCALE double                             immediate_to_double(void *);
+#endif
 LOCALE unsigned long                      hash_atom(char *, unsigned long);
+LOCALE unsigned long long                 hash_atom_bytes(char *, size_t);
 LOCALE unsigned long                      hash_float(double, unsigned long);
 LOCALE unsigned long                      hash_integer(long long, unsigned long);
 LOCALE unsigned long                      hash_bitmap(char *, unsigned long, unsigned);
@@ -250,11 +343,11 @@ LOCALE void                               dec_bitmap_count(void *, struct bitmap
 LOCALE void                               dec_external_address_count(void *, struct external_address_hash_node *);
 LOCALE void                               remove_ephemeral_atoms(void *);
 LOCALE struct atom_hash_node        **    get_symbol_table(void *);
-LOCALE void                               set_symbol_table(void *, struct atom_hash_node **);
+LOCALE unsigned long                      get_symbol_table_size(void *);
 LOCALE struct float_hash_node          ** get_float_table(void *);
-LOCALE void                               set_float_table(void *, struct float_hash_node **);
+LOCALE unsigned long                      get_float_table_size(void *);
 LOCALE struct integer_hash_node       **  get_integer_table(void *);
-LOCALE void                               set_integer_table(void *, struct integer_hash_node **);
+LOCALE unsigned long                      get_integer_table_size(void *);
 LOCALE struct bitmap_hash_node        **  get_bitmap_table(void *);
 LOCALE void                               set_bitmap_table(void *, struct bitmap_hash_node **);
 LOCALE struct external_address_hash_node